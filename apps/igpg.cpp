@@ -5,6 +5,7 @@
 
 #include "formats.hpp"
 #include "rsa.hpp"
+#include "mpn.hpp"
 
 using namespace isg;
 
@@ -28,8 +29,10 @@ void print_version()
               << "Pubkey: RSA" << '\n'
               << "Cipher: AES256" << '\n'
               << "Hash: SHA256" << '\n'
-              << "Compression: Uncompressed"
-//              << "Compression: Uncompressed, ZIP"
+              << "Compression: Uncompressed" << '\n'
+//              << "Compression: Uncompressed, ZIP" << '\n'
+              << '\n'
+              << "Limb kernels: " << mpn::kernels_name(mpn::current_kernels())
               << std::endl;
 }
 
@@ -0,0 +1,149 @@
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "intbig_t.h"
+#include "montgomery_ctx.hpp"
+
+using namespace isg;
+
+namespace
+{
+    struct exponent_kind
+    {
+        const char* name;
+        intbig_t e;
+    };
+
+    // Microseconds per power, one entry per run
+    typedef std::vector<double> samples_t;
+
+    double percentile(samples_t xs, const double p)
+    {
+        std::sort(xs.begin(), xs.end());
+
+        return xs[std::min(xs.size() - 1, size_t(p * xs.size()))];
+    }
+
+    void print_row(const std::string& name, const samples_t& xs)
+    {
+        double mean = 0;
+
+        for(const double x : xs) {
+            mean += x;
+        }
+
+        mean /= xs.size();
+
+        double var = 0;
+
+        for(const double x : xs) {
+            var += (x - mean) * (x - mean);
+        }
+
+        std::cout << std::left << std::setw(18) << name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(10) << percentile(xs, 0)
+                  << std::setw(10) << percentile(xs, 0.5)
+                  << std::setw(10) << percentile(xs, 0.99)
+                  << std::setw(10) << percentile(xs, 1)
+                  << std::setw(10) << std::sqrt(var / xs.size()) << std::endl;
+    }
+}
+
+/**
+ * Latencies of modular powers with an n-bit odd modulus and n-bit exponents of a low, random and full Hamming weight,
+ * by the sliding window (`at_power`) and by the fixed one (`at_power_sec`), which `rsa::key_priv` uses.
+ *
+ * Besides the percentiles over all the runs of a method, "by weight" is the range of its medians for the three kinds
+ * of exponents: the time the fixed window takes shouldn't depend on what the exponent is.
+ */
+int main(int argc, char** argv)
+{
+    if(argc > 3) {
+        std::cerr << "Usage:\n"
+                  << "  \33[4mmodexp_bench\33[0m [<n-bits> [<runs>]]" << std::endl;
+        return 1;
+    }
+
+    const int64_t n_bits = argc > 1 ? std::stoll(argv[1]) : 2048;
+    const size_t runs = argc > 2 ? std::stoull(argv[2]) : 100;
+
+    if(n_bits < 2 || runs == 0) {
+        std::cerr << "Need at least 2 bits and 1 run" << std::endl;
+        return 1;
+    }
+
+    const intbig_t top = intbig_t::of(1) << (n_bits - 1);
+    const intbig_t all_ones = (intbig_t::of(1) << n_bits) - 1;
+
+    const intbig_t m = intbig_t::random_lte(all_ones) | top | intbig_t::of(1);
+    const montgomery_ctx ctx(m);
+
+    const std::vector<exponent_kind> kinds = {
+            { "sparse", top + 1 },
+            { "random", intbig_t::random_lte(all_ones) | top },
+            { "dense", all_ones }
+    };
+
+    const char* const method_names[] = { "sliding window", "fixed window" };
+
+    // [method][kind]
+    std::vector<std::vector<samples_t>> times(2, std::vector<samples_t>(kinds.size()));
+
+    // Interleaved, so that whatever else is going on on the machine hits all of them alike
+    for(size_t run = 0; run < runs; run++) {
+        const intbig_t x = intbig_t::random_lte(m - 1);
+
+        for(size_t i = 0; i < kinds.size(); i++) {
+            for(size_t method = 0; method < 2; method++) {
+                const auto start = std::chrono::steady_clock::now();
+
+                const intbig_t r = method == 0 ? x.at_power(kinds[i].e, ctx) : x.at_power_sec(kinds[i].e, ctx);
+
+                const auto end = std::chrono::steady_clock::now();
+
+                // Keeps the power from being thrown away
+                if(r.sign < 0) {
+                    return 1;
+                }
+
+                times[method][i].push_back(std::chrono::duration<double, std::micro>(end - start).count());
+            }
+        }
+    }
+
+    std::cout << n_bits << "-bit modulus and exponents, " << runs << " runs of each, microseconds\n" << std::endl;
+
+    std::cout << std::left << std::setw(18) << "" << std::right
+              << std::setw(10) << "min" << std::setw(10) << "p50" << std::setw(10) << "p99"
+              << std::setw(10) << "max" << std::setw(10) << "stddev" << std::endl;
+
+    for(size_t method = 0; method < 2; method++) {
+        std::cout << '\n' << method_names[method] << std::endl;
+
+        samples_t all;
+        double p50_min = HUGE_VAL, p50_max = 0;
+
+        for(size_t i = 0; i < kinds.size(); i++) {
+            const samples_t& xs = times[method][i];
+
+            print_row(std::string("  ") + kinds[i].name, xs);
+
+            all.insert(all.end(), xs.begin(), xs.end());
+
+            p50_min = std::min(p50_min, percentile(xs, 0.5));
+            p50_max = std::max(p50_max, percentile(xs, 0.5));
+        }
+
+        print_row("  all", all);
+
+        std::cout << "  by weight: " << std::setprecision(1) << p50_max - p50_min << " ("
+                  << 100 * (p50_max - p50_min) / p50_min << "%)" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,52 @@
+#ifndef RSA_PREP_BARRETT_CTX_HPP
+#define RSA_PREP_BARRETT_CTX_HPP
+
+#include <vector>
+
+#include "intbig_t.h"
+#include "mpn.hpp"
+
+namespace isg
+{
+
+/**
+ * Reduction modulo a fixed `m` by Barrett's method (HAC, algorithm 14.42).
+ *
+ * With m of k limbs and mu = floor(B^2k / m) computed once, the quotient of any x < B^2k by m is estimated by two
+ * multiplications instead of a division, and is at most 2 short. Unlike Montgomery's reduction, this works for even
+ * moduli too, and needs no conversion of the operands.
+ *
+ * Cheaper than `%` from a couple of reductions on: holding one is the point.
+ */
+class barrett_ctx
+{
+    intbig_t m;
+    size_t k;
+
+    // floor(B^2k / m), k + 1 limbs (or k + 2 when m is a power of B)
+    std::vector<mpn::limb_t> mu;
+
+public:
+    // m > 0
+    explicit barrett_ctx(const intbig_t& m);
+
+    const intbig_t& modulus() const { return m; }
+
+    // The number of limbs of the modulus, and thus of the results of `reduce_limbs`
+    size_t size() const { return k; }
+
+    /**
+     * {rp, k} = {xp, xn} mod m, for any xn, though it's only the x < B^2k that don't take a division. `rp` mustn't
+     * overlap {xp, xn}.
+     */
+    void reduce_limbs(mpn::limb_t* rp, const mpn::limb_t* xp, size_t xn) const;
+
+    // x mod m, for x >= 0
+    intbig_t reduce(const intbig_t& x) const;
+    // a * b mod m, for a, b >= 0
+    intbig_t mul_mod(const intbig_t& a, const intbig_t& b) const;
+};
+
+}
+
+#endif //RSA_PREP_BARRETT_CTX_HPP
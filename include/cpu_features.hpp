@@ -0,0 +1,31 @@
+
+#ifndef RSA_PREP_CPU_FEATURES_HPP
+#define RSA_PREP_CPU_FEATURES_HPP
+
+namespace isg
+{
+
+/**
+ * Instruction set extensions that the kernels can make use of, as reported by CPUID.
+ *
+ * All false on anything but x86-64 or with a compiler that doesn't have <cpuid.h>.
+ */
+struct cpu_features
+{
+    // MULX: flag-less 64x64 -> 128 multiplication
+    bool bmi2 = false;
+    // ADCX/ADOX: additions along two independent carry chains
+    bool adx = false;
+
+    // AVX-512 Foundation, only when the OS saves the ZMM registers on context switches
+    bool avx512f = false;
+    // AVX-512 IFMA: 52x52 -> 104 multiply-accumulate on 8 lanes
+    bool avx512ifma = false;
+
+    // Detected once, on the first call
+    static const cpu_features& get();
+};
+
+}
+
+#endif //RSA_PREP_CPU_FEATURES_HPP
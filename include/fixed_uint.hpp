@@ -0,0 +1,372 @@
+#ifndef RSA_PREP_FIXED_UINT_HPP
+#define RSA_PREP_FIXED_UINT_HPP
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+#include "intbig_t.h"
+#include "mpn.hpp"
+
+namespace isg
+{
+
+namespace fixed_limbs
+{
+    /**
+     * f(0), f(1)... f(N - 1), unrolled at compile time: the loops over the limbs of a `fixed_uint` have a constant
+     * count, but not a small enough one for the compiler to unroll them all by itself.
+     */
+    template<size_t I, size_t N>
+    struct unrolled
+    {
+        template<typename F>
+        static void run(F& f)
+        {
+            f(I);
+            unrolled<I + 1, N>::run(f);
+        }
+    };
+
+    template<size_t N>
+    struct unrolled<N, N>
+    {
+        template<typename F>
+        static void run(F&) { }
+    };
+
+    template<size_t N, typename F>
+    void for_each(F f)
+    {
+        unrolled<0, N>::run(f);
+    }
+}
+
+/**
+ * A non-negative integer of at most `Bits` bits (a multiple of 64), with its limbs in an array of its own rather than
+ * on the heap, and no sign or length to keep track of: for the RSA moduli of the usual sizes, where all of the numbers
+ * are of the same length anyway.
+ *
+ * Additions and subtractions are modulo 2^Bits, and return the carry or the borrow out of the top limb.
+ */
+template<size_t Bits>
+class fixed_uint
+{
+    static_assert(Bits != 0 && Bits % 64 == 0, "A whole number of limbs");
+
+public:
+    static constexpr size_t N = Bits / 64;
+
+    // Least significant first, same as `intbig_t::limbs`, with all the leading zeroes
+    std::array<mpn::limb_t, N> limbs;
+
+    fixed_uint() : limbs() { }
+
+    static fixed_uint of(const mpn::limb_t x)
+    {
+        fixed_uint r;
+        r.limbs[0] = x;
+
+        return r;
+    }
+
+    // Throws if x is negative or doesn't fit
+    static fixed_uint from(const intbig_t& x)
+    {
+        if(x.sign < 0 || x.limbs.size() > N) {
+            throw std::range_error("Doesn't fit " + std::to_string(Bits) + " bits");
+        }
+
+        fixed_uint r;
+        std::copy(x.limbs.begin(), x.limbs.end(), r.limbs.begin());
+
+        return r;
+    }
+
+    intbig_t to_intbig() const
+    {
+        intbig_t r;
+        r.limbs.assign(limbs.begin(), limbs.begin() + mpn::normalized_size(limbs.data(), N));
+        r.sign = r.limbs.empty() ? 0 : 1;
+
+        return r;
+    }
+
+    bool test_bit(const size_t i) const
+    {
+        return i < Bits && (limbs[i / 64] >> (i % 64) & 1) != 0;
+    }
+
+    size_t num_bits() const
+    {
+        const size_t n = mpn::normalized_size(limbs.data(), N);
+
+        return n == 0 ? 0 : 64 * n - size_t(__builtin_clzll(limbs[n - 1]));
+    }
+
+    mpn::limb_t add(const fixed_uint& other)
+    {
+        mpn::limb_t carry = 0;
+
+        fixed_limbs::for_each<N>([&](const size_t i) {
+            const mpn::limb_t a = limbs[i];
+            const mpn::limb_t s = a + other.limbs[i];
+            const mpn::limb_t r = s + carry;
+
+            carry = mpn::limb_t(s < a) | mpn::limb_t(r < s);
+            limbs[i] = r;
+        });
+
+        return carry;
+    }
+
+    mpn::limb_t sub(const fixed_uint& other)
+    {
+        mpn::limb_t borrow = 0;
+
+        fixed_limbs::for_each<N>([&](const size_t i) {
+            const mpn::limb_t a = limbs[i];
+            const mpn::limb_t b = other.limbs[i];
+            const mpn::limb_t d = a - b;
+
+            limbs[i] = d - borrow;
+            borrow = mpn::limb_t(a < b) | mpn::limb_t(d < borrow);
+        });
+
+        return borrow;
+    }
+
+    // Same as `sub` if `cnd` isn't zero, and a subtraction of zero otherwise, without branching on it
+    mpn::limb_t cnd_sub(const mpn::limb_t cnd, const fixed_uint& other)
+    {
+        const mpn::limb_t mask = mpn::limb_t(0) - mpn::limb_t(cnd != 0);
+
+        fixed_uint masked;
+
+        fixed_limbs::for_each<N>([&](const size_t i) {
+            masked.limbs[i] = other.limbs[i] & mask;
+        });
+
+        return sub(masked);
+    }
+
+    int cmp(const fixed_uint& other) const
+    {
+        for(size_t i = N; i-- > 0; ) {
+            if(limbs[i] != other.limbs[i]) {
+                return limbs[i] < other.limbs[i] ? -1 : 1;
+            }
+        }
+
+        return 0;
+    }
+
+    bool operator==(const fixed_uint& other) const { return limbs == other.limbs; }
+    bool operator!=(const fixed_uint& other) const { return limbs != other.limbs; }
+    bool operator<(const fixed_uint& other) const { return cmp(other) < 0; }
+};
+
+/**
+ * Same as `montgomery_ctx` for a modulus of exactly `Bits / 64` limbs (the top one non-zero), with everything on
+ * `fixed_uint`s: the operands, the products' scratch and the powers' tables are all of a size known beforehand, and
+ * live on the stack.
+ *
+ * The products are `mpn::mont_mul_sec` and `mont_sqr_sec`, the IFMA ones or the basecase ones and `redc`: these never
+ * go to the subquadratic products and their scratch arena, and don't branch on the data, so the same ones do for the
+ * public powers and the secret ones.
+ */
+template<size_t Bits>
+class fixed_montgomery_ctx
+{
+public:
+    typedef fixed_uint<Bits> uint_t;
+
+    static constexpr size_t N = uint_t::N;
+
+private:
+    uint_t m;
+
+    // -m^-1 mod B
+    mpn::limb_t m_inv;
+    // R^2 mod m, and R mod m (that is, 1 in the form)
+    uint_t r2, r1;
+
+    /**
+     * x^e mod m for x in the form, with e of `e_bits` bits at {ep, en}, by fixed windows of bits from the top: a square
+     * per bit, and a multiplication by the window's power of x per window.
+     *
+     * With `sec`, all the `e_bits` are gone through, leading zeroes included, with a multiplication by x^0 for each
+     * zero window, and each power is read off the table by masks (see `intbig_t::at_power_sec`), so that neither the
+     * time nor the memory reads depend on e. Otherwise, zero windows are skipped and the powers are looked up.
+     */
+    uint_t power_limbs(const uint_t& x, const mpn::limb_t* ep, const size_t en, const size_t e_bits,
+                       const bool sec) const
+    {
+        if(e_bits == 0) {
+            return r1;
+        }
+
+        const size_t window = mpn::power_window_bits(e_bits);
+        const size_t n_entries = size_t(1) << window;
+
+        // x^0, x^1, x^2..., interleaved as for `intbig_t::at_power_sec`: limb j of x^i at j * n_entries + i
+        std::array<mpn::limb_t, (size_t(1) << mpn::POWER_MAX_WINDOW) * N> table;
+
+        uint_t t = r1;
+
+        for(size_t i = 0; i < n_entries; i++) {
+            if(i != 0) {
+                t = mul(t, x);
+            }
+
+            for(size_t j = 0; j < N; j++) {
+                table[j * n_entries + i] = t.limbs[j];
+            }
+        }
+
+        const auto entry = [&](const mpn::limb_t bits) {
+            uint_t r;
+
+            if(sec) {
+                for(size_t j = 0; j < N; j++) {
+                    const mpn::limb_t* const row = table.data() + j * n_entries;
+                    mpn::limb_t limb = 0;
+
+                    for(size_t e = 0; e < n_entries; e++) {
+                        limb |= row[e] & (mpn::limb_t(0) - mpn::limb_t(e == bits));
+                    }
+
+                    r.limbs[j] = limb;
+                }
+            }
+            else {
+                for(size_t j = 0; j < N; j++) {
+                    r.limbs[j] = table[j * n_entries + bits];
+                }
+            }
+
+            return r;
+        };
+
+        // Bits [low, low + n) of e
+        const auto window_bits = [&](const size_t low, const size_t n) {
+            const size_t i = low / 64;
+            const unsigned shift = unsigned(low % 64);
+
+            mpn::limb_t bits = ep[i] >> shift;
+
+            if(shift + n > 64 && i + 1 < en) {
+                bits |= ep[i + 1] << (64 - shift);
+            }
+
+            return bits & ((mpn::limb_t(1) << n) - 1);
+        };
+
+        // The top window takes whatever bits are left over by the full ones below it
+        const size_t top = e_bits % window != 0 ? e_bits % window : window;
+        size_t low = e_bits - top;
+
+        uint_t r = entry(window_bits(low, top));
+
+        while(low != 0) {
+            low -= window;
+
+            for(size_t j = 0; j < window; j++) {
+                r = sqr(r);
+            }
+
+            const mpn::limb_t bits = window_bits(low, window);
+
+            if(sec || bits != 0) {
+                r = mul(r, entry(bits));
+            }
+        }
+
+        return r;
+    }
+
+public:
+    // m odd, of exactly N limbs
+    explicit fixed_montgomery_ctx(const uint_t& m) : m(m), m_inv(0)
+    {
+        if(!m.test_bit(0) || m.limbs[N - 1] == 0) {
+            throw std::logic_error("Montgomery's reduction needs an odd modulus of " + std::to_string(Bits) + " bits");
+        }
+
+        m_inv = -mpn::binvert_limb(m.limbs[0]);
+
+        // B^2N mod m
+        std::array<mpn::limb_t, 2 * N + 1> b2n = { };
+        b2n.back() = 1;
+
+        std::array<mpn::limb_t, N + 2> q;
+
+        mpn::divrem(q.data(), r2.limbs.data(), b2n.data(), b2n.size(), m.limbs.data(), N);
+
+        r1 = from_mont(r2);
+    }
+
+    const uint_t& modulus() const { return m; }
+
+    // a * b / R mod m, for a, b below m
+    uint_t mul(const uint_t& a, const uint_t& b) const
+    {
+        uint_t r;
+        std::array<mpn::limb_t, 2 * N> tp;
+
+        mpn::mont_mul_sec(r.limbs.data(), a.limbs.data(), b.limbs.data(), m.limbs.data(), N, m_inv, tp.data());
+
+        return r;
+    }
+
+    // a^2 / R mod m, for a below m
+    uint_t sqr(const uint_t& a) const
+    {
+        uint_t r;
+        std::array<mpn::limb_t, 2 * N> tp;
+
+        mpn::mont_sqr_sec(r.limbs.data(), a.limbs.data(), m.limbs.data(), N, m_inv, tp.data());
+
+        return r;
+    }
+
+    // x * R mod m, for any x: any x < B^N will do, as its product with R^2 mod m is below m * R
+    uint_t to_mont(const uint_t& x) const
+    {
+        return mul(x, r2);
+    }
+
+    // x / R mod m
+    uint_t from_mont(const uint_t& x) const
+    {
+        uint_t r;
+        std::array<mpn::limb_t, 2 * N> tp = { };
+
+        std::copy(x.limbs.begin(), x.limbs.end(), tp.begin());
+
+        mpn::redc(r.limbs.data(), tp.data(), m.limbs.data(), N, m_inv);
+
+        return r;
+    }
+
+    // x^e mod m, for any x not in the form, and a public e
+    uint_t power(const uint_t& x, const intbig_t& e) const
+    {
+        if(e.sign < 0) {
+            throw std::logic_error("Can't raise to negative power " + e.to_string());
+        }
+
+        return from_mont(power_limbs(to_mont(x), e.limbs.data(), e.limbs.size(), e.num_bits(), false));
+    }
+
+    // Same as the above for a secret e, taking the same time for any e of `EBits` bits
+    template<size_t EBits>
+    uint_t power_sec(const uint_t& x, const fixed_uint<EBits>& e) const
+    {
+        return from_mont(power_limbs(to_mont(x), e.limbs.data(), fixed_uint<EBits>::N, EBits, true));
+    }
+};
+
+}
+
+#endif //RSA_PREP_FIXED_UINT_HPP
@@ -8,6 +8,12 @@
 
 #include <iostream> // For the stream i/o methods
 
+namespace isg
+{
+class barrett_ctx;
+class montgomery_ctx;
+}
+
 // TODO: put everything in a namespace
 class intbig_t
 {
@@ -85,6 +91,7 @@ public:
     uint64_t factor2() const;
 
     // TODO: Find a way to test the random number constructors
+    // Exactly `n_bits` long, with the top bit set
     static intbig_t random_bits(size_t n_bits);
     static intbig_t random_lte(const intbig_t& x_max);
 
@@ -194,6 +201,16 @@ public:
 
     uint64_t divmod(uint64_t);
 
+    /**
+     * The remainder of the absolute value, without writing the quotient anywhere
+     */
+    uint64_t mod(uint64_t) const;
+
+    /**
+     * The remainders of the numbers' absolute values, with the reciprocal of the divisor computed once for all of them
+     */
+    static std::vector<uint64_t> mod_each(const std::vector<intbig_t>& xs, uint64_t);
+
     intbig_t& operator*=(int64_t);
     intbig_t& operator/=(int64_t);
     intbig_t& operator%=(int64_t);
@@ -202,8 +219,24 @@ public:
     intbig_t operator/(int64_t) const;
     int64_t operator%(int64_t) const;
 
+    /**
+     * Truncating division: leaves the quotient in place and returns the remainder, which takes the dividend's sign
+     */
     intbig_t divmod(const intbig_t& other);
 
+    /**
+     * In-place division by a number known to divide this one, without a remainder -- much faster than `/=` when the
+     * quotient is short. If `other` doesn't divide it, the result is meaningless.
+     */
+    intbig_t& divexact(const intbig_t& other);
+
+    /**
+     * Products and squares of huge numbers can run on several threads, see `isg::mpn::set_max_threads`.
+     *
+     * The in-place operations take their temporaries from the scratch arena of `isg::mpn`, so that a loop of them on
+     * numbers of bounded size (such as a modular power's) stops allocating once the arena and the operands have grown.
+     */
+
     intbig_t& operator*=(const intbig_t& other);
     intbig_t& operator/=(const intbig_t& other);
     intbig_t& operator%=(const intbig_t& other);
@@ -217,16 +250,67 @@ public:
     intbig_t& to_power(const intbig_t& pow);
     intbig_t  at_power(const intbig_t& pow) const;
 
-    /**
-     * TODO: Reimplement both modular product and modular power through Montgomery reduction.
-     */
-
     intbig_t& mul_mod(const intbig_t& other, const intbig_t& m);
     intbig_t  times_mod(const intbig_t& other, const intbig_t& m) const;
 
+    /**
+     * The power is taken in Montgomery's form for an odd `m` (see `isg::montgomery_ctx`), and with Barrett's reduction
+     * for an even one
+     */
     intbig_t& to_power(const intbig_t& pow, const intbig_t& m);
     intbig_t  at_power(const intbig_t& pow, const intbig_t& m) const;
 
+    /**
+     * Same as the above, with the reductions done by Barrett's method (see `isg::barrett_ctx`), for the callers that
+     * keep using the same modulus. The products go through `isg::modint`, which is what a chain of them should hold
+     * instead.
+     */
+    intbig_t& mul_mod(const intbig_t& other, const isg::barrett_ctx& m);
+    intbig_t  times_mod(const intbig_t& other, const isg::barrett_ctx& m) const;
+
+    intbig_t& to_power(const intbig_t& pow, const isg::barrett_ctx& m);
+    intbig_t  at_power(const intbig_t& pow, const isg::barrett_ctx& m) const;
+
+    // Same as the above, in Montgomery's form, which is cheaper still but only works for an odd `m`
+    intbig_t& to_power(const intbig_t& pow, const isg::montgomery_ctx& m);
+    intbig_t  at_power(const intbig_t& pow, const isg::montgomery_ctx& m) const;
+
+    /**
+     * Same as the above with a fixed window, for secret exponents: which products are taken and which memory is read
+     * depends on the sizes of the numbers only, not on the bits of `pow`. It's somewhat slower, as every window takes
+     * a multiplication, even by x^0, and every entry of the table is read for each one, and the products stay on the
+     * basecase and IFMA kernels (see `mpn::mont_mul_sec`) even where Karatsuba's would be faster.
+     */
+    intbig_t& to_power_sec(const intbig_t& pow, const isg::montgomery_ctx& m);
+    intbig_t  at_power_sec(const intbig_t& pow, const isg::montgomery_ctx& m) const;
+
+    /**
+     * 2^e mod m, the power a base-2 pseudoprime test takes. Multiplying by 2 is a shift and a subtraction at most, so
+     * it's only the squares that cost anything. With an odd `m`, it's taken in Montgomery's form.
+     */
+    static intbig_t pow2_mod(const intbig_t& e, const intbig_t& m);
+    static intbig_t pow2_mod(const intbig_t& e, const isg::montgomery_ctx& m);
+
+    // Pairs of a base and its exponent
+    typedef std::vector<std::pair<intbig_t, intbig_t>> power_terms;
+
+    /**
+     * x_0^e_0 * x_1^e_1... mod m for the pairs (x_t, e_t) of `terms`, all of them non-negative, by Straus's method: the
+     * powers share their chain of squares, so that two of them take little more time than one. The reductions are as
+     * with `at_power`.
+     */
+    static intbig_t multi_power_mod(const power_terms& terms, const intbig_t& m);
+    static intbig_t multi_power_mod(const power_terms& terms, const isg::barrett_ctx& m);
+    static intbig_t multi_power_mod(const power_terms& terms, const isg::montgomery_ctx& m);
+
+    /**
+     * xs[i]^pows[i] mod ms[i] for each i, all of them non-negative, with odd moduli. With the avx512_ifma kernels, the
+     * powers modulo numbers of the same size go POWER_BATCH_LANES at a time (see `isg::mpn::power_batch_ifma`), the
+     * rest one by one; the results are the same as `at_power`'s either way.
+     */
+    static std::vector<intbig_t> power_mod_batch(const std::vector<intbig_t>& xs, const std::vector<intbig_t>& pows,
+                                                 const std::vector<intbig_t>& ms);
+
     intbig_t inverse_mod(const intbig_t& m) const;
 
     int64_t gcd(int64_t) const;
@@ -0,0 +1,67 @@
+#ifndef RSA_PREP_MODINT_HPP
+#define RSA_PREP_MODINT_HPP
+
+#include <vector>
+
+#include "intbig_t.h"
+#include "mpn.hpp"
+#include "barrett_ctx.hpp"
+#include "montgomery_ctx.hpp"
+
+namespace isg
+{
+
+/**
+ * A residue modulo the modulus of a context (`barrett_ctx` or `montgomery_ctx`), which has to outlive it.
+ *
+ * The value is always reduced and held in k limbs, in Montgomery's form with the latter, so a product is one full
+ * multiplication and one reduction, and a sum or a difference is an addition and a conditional correction, without the
+ * checks, the conversions and the normalization of going through `intbig_t` each time.
+ *
+ * Residues modulo different contexts don't mix, even if their moduli are equal.
+ */
+template<typename Ctx>
+class modint
+{
+    const Ctx* ctx;
+
+    // k limbs, below m
+    std::vector<mpn::limb_t> v;
+
+    // Zero, to be filled in
+    explicit modint(const Ctx& ctx);
+
+    void check_ctx(const modint& other) const;
+
+public:
+    // x mod m, for x >= 0
+    modint(const Ctx& ctx, const intbig_t& x);
+
+    const Ctx& context() const { return *ctx; }
+
+    // The residue itself, in [0, m)
+    intbig_t value() const;
+
+    modint& operator+=(const modint& other);
+    modint& operator-=(const modint& other);
+    modint& operator*=(const modint& other);
+
+    modint operator+(const modint& other) const;
+    modint operator-(const modint& other) const;
+    modint operator*(const modint& other) const;
+
+    modint& square();
+    modint squared() const;
+
+    // this^e, for e >= 0
+    modint pow(const intbig_t& e) const;
+    // this^-1, throws if there's none
+    modint inverse() const;
+
+    bool operator==(const modint& other) const;
+    bool operator!=(const modint& other) const;
+};
+
+}
+
+#endif //RSA_PREP_MODINT_HPP
@@ -0,0 +1,74 @@
+#ifndef RSA_PREP_MONTGOMERY_CTX_HPP
+#define RSA_PREP_MONTGOMERY_CTX_HPP
+
+#include <vector>
+
+#include "intbig_t.h"
+#include "mpn.hpp"
+
+namespace isg
+{
+
+/**
+ * Arithmetic modulo a fixed odd `m` in Montgomery's form (HAC, section 14.3.2), where x stands for x * R mod m with
+ * R = B^k for m of k limbs.
+ *
+ * The product of two numbers in this form is reduced by REDC, which divides by R rather than by m: k multiplications
+ * by a limb and a shift, no quotient estimates and no corrections but the last subtraction. Getting into the form and
+ * out of it takes a product apiece, so it's for long chains of products modulo the same number, like powers.
+ */
+class montgomery_ctx
+{
+    intbig_t m;
+    size_t k;
+
+    // -m^-1 mod B
+    mpn::limb_t m_inv;
+    // R^2 mod m, k limbs
+    std::vector<mpn::limb_t> r2;
+
+public:
+    // m > 0, odd
+    explicit montgomery_ctx(const intbig_t& m);
+
+    const intbig_t& modulus() const { return m; }
+
+    // The number of limbs of the modulus, and thus of the numbers in Montgomery's form
+    size_t size() const { return k; }
+
+    /*
+     * The same on limbs, with all the numbers in the form being k limbs long and below m. `rp` may coincide with the
+     * operands.
+     */
+
+    // {rp, k} = {xp, xn} * R mod m, for any xn
+    void to_mont_limbs(mpn::limb_t* rp, const mpn::limb_t* xp, size_t xn) const;
+    // {rp, k} = {ap, k} / R mod m
+    void from_mont_limbs(mpn::limb_t* rp, const mpn::limb_t* ap) const;
+
+    // {rp, k} = {ap, k} * {bp, k} / R mod m
+    void mul_limbs(mpn::limb_t* rp, const mpn::limb_t* ap, const mpn::limb_t* bp) const;
+    // {rp, k} = {ap, k}^2 / R mod m
+    void sqr_limbs(mpn::limb_t* rp, const mpn::limb_t* ap) const;
+
+    // Same as the two above on the kernels that don't branch on the data (`mpn::mont_mul_sec`), for secret operands
+    void mul_limbs_sec(mpn::limb_t* rp, const mpn::limb_t* ap, const mpn::limb_t* bp) const;
+    void sqr_limbs_sec(mpn::limb_t* rp, const mpn::limb_t* ap) const;
+
+    // x * R mod m, for x >= 0
+    intbig_t to_mont(const intbig_t& x) const;
+    // x / R mod m, for x in the form
+    intbig_t from_mont(const intbig_t& x) const;
+
+    // a * b / R mod m, for a, b in the form
+    intbig_t mul(const intbig_t& a, const intbig_t& b) const;
+    // a^2 / R mod m, for a in the form
+    intbig_t sqr(const intbig_t& a) const;
+
+    // a * b mod m, for a, b >= 0 not in the form
+    intbig_t mul_mod(const intbig_t& a, const intbig_t& b) const;
+};
+
+}
+
+#endif //RSA_PREP_MONTGOMERY_CTX_HPP
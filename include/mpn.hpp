@@ -0,0 +1,442 @@
+
+#ifndef RSA_PREP_MPN_HPP
+#define RSA_PREP_MPN_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace isg {
+namespace mpn {
+
+/**
+ * Low-level arithmetic on natural numbers, after GMP's `mpn` layer.
+ *
+ * A number is a pointer to its least significant limb plus the count of limbs (base 2^64, little-endian). Unless
+ * stated otherwise:
+ *
+ *   - the destination `rp` has room for the whole result;
+ *   - `rp` may coincide with a source operand, but must not partially overlap it;
+ *   - operands of length 0 are allowed;
+ *   - nothing here normalizes -- leading zeroes are the caller's business;
+ *   - nothing here allocates either, save for the thread's scratch arena (see `scratch_frame`).
+ *
+ * Both `intbig_t` and everything that needs more than it can express (Karatsuba, Montgomery, Knuth division) are
+ * supposed to be built on top of these.
+ */
+
+typedef uint64_t limb_t;
+
+constexpr unsigned LIMB_BITS = 64;
+
+/**
+ * Perform "full word" multiplication on limbs.
+ *
+ * Where the compiler has 128-bit integers, that's a single instruction; elsewhere, it's four 32x32 -> 64 products.
+ *
+ * @return Two-limb product of @code a and @code b, as { low, high }
+ */
+inline std::pair<limb_t, limb_t> mul_full(const limb_t a, const limb_t b)
+{
+#ifdef __SIZEOF_INT128__
+    const unsigned __int128 prod = static_cast<unsigned __int128>(a) * b;
+
+    return { limb_t(prod), limb_t(prod >> 64) };
+#else
+    const limb_t a_low = a & 0xFFFFFFFF;
+    const limb_t a_high = a >> 32;
+    const limb_t b_low = b & 0xFFFFFFFF;
+    const limb_t b_high = b >> 32;
+
+    const limb_t z0 = a_low * b_low;
+
+    limb_t z1 = a_high * b_low;
+    const limb_t z11 = a_low * b_high;
+
+    limb_t z2 = a_high * b_high;
+
+    z1 += z0 >> 32;
+    z1 += z11;
+
+    if(z1 < z11) {
+        z2 += 1ULL << 32;
+    }
+
+    return { (z1 << 32) + (z0 & 0xFFFFFFFF), z2 + (z1 >> 32) };
+#endif
+}
+
+// The length of {ap, n} without its leading zeroes
+size_t normalized_size(const limb_t* ap, size_t n);
+
+// Sign of {ap, n} - {bp, n}
+int cmp(const limb_t* ap, const limb_t* bp, size_t n);
+
+/*
+ * Additive operations: return the carry (borrow) out of the most significant limb
+ */
+
+// {rp, n} = {ap, n} + b
+limb_t add_1(limb_t* rp, const limb_t* ap, size_t n, limb_t b);
+// {rp, n} = {ap, n} + {bp, n}
+limb_t add_n(limb_t* rp, const limb_t* ap, const limb_t* bp, size_t n);
+// {rp, an} = {ap, an} + {bp, bn}, an >= bn
+limb_t add(limb_t* rp, const limb_t* ap, size_t an, const limb_t* bp, size_t bn);
+
+// {rp, n} = {ap, n} - b
+limb_t sub_1(limb_t* rp, const limb_t* ap, size_t n, limb_t b);
+// {rp, n} = {ap, n} - {bp, n}
+limb_t sub_n(limb_t* rp, const limb_t* ap, const limb_t* bp, size_t n);
+// {rp, an} = {ap, an} - {bp, bn}, an >= bn
+limb_t sub(limb_t* rp, const limb_t* ap, size_t an, const limb_t* bp, size_t bn);
+
+// {rp, n} = {ap, n} + {bp, n} if `cnd` is non-zero, {ap, n} + 0 otherwise: the same loads and the same time either way
+limb_t cnd_add_n(limb_t cnd, limb_t* rp, const limb_t* ap, const limb_t* bp, size_t n);
+
+/*
+ * Multiplication by a single limb: return the most significant limb of the result
+ */
+
+// {rp, n} = {ap, n} * b
+limb_t mul_1(limb_t* rp, const limb_t* ap, size_t n, limb_t b);
+// {rp, n} += {ap, n} * b; `rp` and `ap` must not overlap
+limb_t addmul_1(limb_t* rp, const limb_t* ap, size_t n, limb_t b);
+// {rp, n} -= {ap, n} * b; `rp` and `ap` must not overlap
+limb_t submul_1(limb_t* rp, const limb_t* ap, size_t n, limb_t b);
+
+/**
+ * The three above are the innermost loops of everything quadratic, and come in variants for different instruction sets:
+ *
+ *   - portable: plain C++ over `mul_full`;
+ *   - mulx_adx: x86-64 assembly with MULX and two carry chains of ADCX/ADOX (Broadwell and Zen onwards);
+ *   - avx512_ifma: same as mulx_adx, plus the AVX-512 IFMA products and Montgomery products (see below) for the sizes
+ *     of RSA's numbers (Ice Lake and Zen 4 onwards).
+ *
+ * The best one the CPU supports is picked at startup.
+ */
+enum class kernels { portable, mulx_adx, avx512_ifma };
+
+kernels current_kernels();
+const char* kernels_name(kernels k);
+
+bool kernels_supported(kernels k);
+
+// Switches to the given variant if it's supported -- for testing and benchmarking the others. Not thread-safe.
+bool select_kernels(kernels k);
+
+/*
+ * Exact division by a single limb
+ */
+
+// Inverse of an odd `d` modulo 2^64
+limb_t binvert_limb(limb_t d);
+// {rp, n} = {ap, n} / d for odd `d` -- or, rather, {ap, n} * d^-1 mod B^n, which is the same when `d` divides `a`
+void divexact_1(limb_t* rp, const limb_t* ap, size_t n, limb_t d);
+
+/*
+ * Scratch space
+ *
+ * The temporary limbs of the products, squares and divisions come from an arena of the calling thread's, a stack of
+ * blocks that are never given back: once it has grown to what an operation takes, repeating that operation doesn't
+ * touch the heap anymore.
+ */
+
+/**
+ * Everything allocated through a frame is released at once when it goes out of scope, so frames have to be nested the
+ * same way as the calls they're in -- which is all there is to it as long as they're only ever local variables.
+ *
+ * The limbs aren't initialized.
+ */
+class scratch_frame
+{
+public:
+    scratch_frame();
+    ~scratch_frame();
+
+    scratch_frame(const scratch_frame&) = delete;
+    scratch_frame& operator=(const scratch_frame&) = delete;
+
+    limb_t* alloc(size_t n);
+
+private:
+    // Where the arena's top was when the frame was made
+    size_t block;
+    size_t used;
+};
+
+/*
+ * Shifts by 0 < cnt < 64 bits: return the bits shifted out
+ */
+
+// {rp, n} = {ap, n} << cnt, the bits shifted out are in the low bits of the result; allows rp >= ap
+limb_t lshift(limb_t* rp, const limb_t* ap, size_t n, unsigned cnt);
+// {rp, n} = {ap, n} >> cnt, the bits shifted out are in the high bits of the result; allows rp <= ap
+limb_t rshift(limb_t* rp, const limb_t* ap, size_t n, unsigned cnt);
+
+/*
+ * Full products: {rp, an + bn} = {ap, an} * {bp, bn}, an, bn >= 1, `rp` overlaps neither operand
+ *
+ * The specific algorithms require an >= bn, the dispatcher takes the operands in either order and picks one of them
+ * by the thresholds below.
+ */
+
+/**
+ * Smallest operand size (in limbs) multiplied by Karatsuba instead of schoolbook.
+ *
+ * Benchmarked on balanced operands with the MULX/ADX kernels; GMP has it around 30 limbs.
+ */
+constexpr size_t MUL_KARATSUBA_THRESHOLD = 32;
+
+/**
+ * Smallest sizes of `b` multiplied by the Toom-Cook algorithms, balanced (3- and 4-way) and unbalanced (`a` split into
+ * 3 or 4 pieces, `b` into 2).
+ *
+ * GMP has the balanced ones at 100 and 300 limbs. Ours are benchmarked the same way as Karatsuba's, and are higher
+ * because of the generic interpolation.
+ */
+constexpr size_t MUL_TOOM33_THRESHOLD = 200;
+constexpr size_t MUL_TOOM44_THRESHOLD = 500;
+constexpr size_t MUL_TOOM32_THRESHOLD = 160;
+constexpr size_t MUL_TOOM42_THRESHOLD = 160;
+
+/**
+ * Smallest size of `b` multiplied through the number-theoretic transform, which takes O(n * log(n)).
+ *
+ * The transforms' lengths are powers of two, so its timing is a staircase rather than a curve: this is about where it
+ * gets below toom44 for good, which is some 640 thousand bits.
+ */
+constexpr size_t MUL_NTT_THRESHOLD = 10000;
+
+void mul_basecase(limb_t* rp, const limb_t* ap, size_t an, const limb_t* bp, size_t bn);
+
+/*
+ * Toom-Cook "k-way" algorithms split `a` into `ka` and `b` into `kb` pieces of n limbs (the top ones shorter, but not
+ * empty), where n is the least that fits all pieces of both. All but the top pieces have to be full, hence the
+ * operands' sizes can't be too far apart:
+ *
+ *   - Karatsuba (toom22): requires bn > ceil(an / 2);
+ *   - toom33: requires bn > 2 * ceil(an / 3);
+ *   - toom44: requires bn > 3 * ceil(an / 4);
+ *   - toom32 and toom42: require an > 2 * n or an > 3 * n, respectively, and bn > n.
+ */
+void mul_karatsuba(limb_t* rp, const limb_t* ap, size_t an, const limb_t* bp, size_t bn);
+void mul_toom33(limb_t* rp, const limb_t* ap, size_t an, const limb_t* bp, size_t bn);
+void mul_toom44(limb_t* rp, const limb_t* ap, size_t an, const limb_t* bp, size_t bn);
+void mul_toom32(limb_t* rp, const limb_t* ap, size_t an, const limb_t* bp, size_t bn);
+void mul_toom42(limb_t* rp, const limb_t* ap, size_t an, const limb_t* bp, size_t bn);
+
+// Any sizes will do, as long as an + bn <= 2^55
+void mul_ntt(limb_t* rp, const limb_t* ap, size_t an, const limb_t* bp, size_t bn);
+
+/**
+ * Sizes that the AVX-512 IFMA products handle, in radix 2^52: 1024 to 4096 bits, the ones of RSA's numbers.
+ *
+ * Mustn't be called unless the avx512_ifma kernels are supported, which is when `mul` picks them, for a `b` of at least
+ * MUL_IFMA_THRESHOLD limbs: at 16 the vectors don't win over the scalar code yet.
+ */
+constexpr size_t IFMA_MIN_LIMBS = 16;
+constexpr size_t IFMA_MAX_LIMBS = 64;
+
+constexpr size_t MUL_IFMA_THRESHOLD = 24;
+
+// IFMA_MIN_LIMBS <= bn <= an <= IFMA_MAX_LIMBS
+void mul_ifma(limb_t* rp, const limb_t* ap, size_t an, const limb_t* bp, size_t bn);
+
+void mul(limb_t* rp, const limb_t* ap, size_t an, const limb_t* bp, size_t bn);
+
+/*
+ * Parallel multiplication, off by default
+ *
+ * With more than one thread allowed, the products (and squares) with a `b` of at least MUL_PARALLEL_THRESHOLD limbs
+ * run their independent parts on a pool of threads: the smaller products of the Karatsuba and Toom-Cook steps, and the
+ * NTT's convolutions modulo each of its primes.
+ */
+
+// Some 64 thousand bits: a toom44 step's products take about a millisecond there, which dwarfs the threads' overhead
+constexpr size_t MUL_PARALLEL_THRESHOLD = 1000;
+
+/**
+ * The most threads a product may run on, the calling one included. 0 stands for as many as the CPU has.
+ *
+ * May be called at any time, from any thread: the products already running finish on the threads they started with.
+ */
+void set_max_threads(unsigned n);
+unsigned max_threads();
+
+// Whether a product with `b` of `bn` limbs is to run in parallel
+bool use_threads(size_t bn);
+// Runs the tasks on the threads and returns once all of them are done
+void run_parallel(const std::vector<std::function<void()>>& tasks);
+
+/*
+ * Squares: {rp, 2 * n} = {ap, n}^2, n >= 1, `rp` doesn't overlap `ap`
+ *
+ * The same ladder as the products', with each rung cheaper than the corresponding product: the schoolbook one computes
+ * each cross product once, and the rest square their smaller numbers instead of multiplying them. `mul` comes here by
+ * itself when both operands are the same number.
+ */
+
+/**
+ * Thresholds, on the square's own benchmarks. Squaring's basecase gains the most from the symmetry, so it holds out
+ * longer than the multiplication's.
+ */
+constexpr size_t SQR_KARATSUBA_THRESHOLD = 64;
+constexpr size_t SQR_TOOM3_THRESHOLD = 250;
+constexpr size_t SQR_TOOM4_THRESHOLD = 600;
+// Lower than the multiplication's one, as a square needs one transform less
+constexpr size_t SQR_NTT_THRESHOLD = 7000;
+
+void sqr_basecase(limb_t* rp, const limb_t* ap, size_t n);
+
+// Same requirements on n as the products' for an = bn, that is n >= 2, 5 and 13, respectively
+void sqr_karatsuba(limb_t* rp, const limb_t* ap, size_t n);
+void sqr_toom3(limb_t* rp, const limb_t* ap, size_t n);
+void sqr_toom4(limb_t* rp, const limb_t* ap, size_t n);
+
+void sqr_ntt(limb_t* rp, const limb_t* ap, size_t n);
+
+void sqr(limb_t* rp, const limb_t* ap, size_t n);
+
+// How many times `mul` and `sqr` have gone past the basecase on this thread, for checking that a path never does
+size_t subquadratic_calls();
+
+/*
+ * Division
+ */
+
+/**
+ * A single-limb divisor, along with what dividing by it takes: its normalization shift and the reciprocal of the
+ * normalized one, so that each limb divided is two multiplications rather than a hardware division (Moller and
+ * Granlund, "Improved division by invariant integers"). Worth it when dividing more than a few limbs by it.
+ */
+struct divisor_1
+{
+    // d << shift, which has its top bit set
+    limb_t d_norm;
+    unsigned shift;
+    // floor((B^2 - 1) / d_norm) - B
+    limb_t inv;
+
+    // d != 0
+    explicit divisor_1(limb_t d);
+};
+
+// The reciprocal as above, of a normalized `d`
+limb_t invert_limb(limb_t d);
+
+// {qp, n} = {ap, n} / d, returns the remainder; `qp` may coincide with `ap`
+limb_t divrem_1(limb_t* qp, const limb_t* ap, size_t n, const divisor_1& d);
+// {ap, n} mod d
+limb_t mod_1(const limb_t* ap, size_t n, const divisor_1& d);
+// {rs, k} = {ap, n} mod each of {ds, k}, all in the same pass over the limbs
+void mod_1_many(limb_t* rs, const limb_t* ap, size_t n, const divisor_1* ds, size_t k);
+
+/**
+ * {qp, nn - dn + 1} = {np, nn} / {dp, dn} and {rp, dn} = {np, nn} mod {dp, dn}, for nn >= dn >= 1 and a `d` without
+ * leading zeroes. `rp` may coincide with `np`, `qp` must not overlap anything.
+ */
+void divrem(limb_t* qp, limb_t* rp, const limb_t* np, size_t nn, const limb_t* dp, size_t dn);
+
+/**
+ * Smallest size of `d`, as well as of the quotient, divided by the divide-and-conquer algorithm.
+ *
+ * Its recursion turns the division into products of half the size, so it takes off about where those are Karatsuba's
+ * in the first place. Benchmarked on 2n-by-n divisions; GMP has it around 50 limbs.
+ */
+constexpr size_t DIV_DC_THRESHOLD = 40;
+
+/*
+ * The algorithms under `divrem`, on a normalized `d` (its top bit set) of dn >= 2 limbs, nn >= dn: {qp, nn - dn} is
+ * the quotient and the returned limb (0 or 1) the one above it, with the remainder left in {np, dn}.
+ *
+ * The schoolbook one is Knuth's algorithm D, O((nn - dn) * dn). The divide-and-conquer one is Burnikel and Ziegler's,
+ * which makes a 2n-by-n division out of two n-by-n/2 ones and two products of n/2 limbs, so it's O(M(dn) * log(dn))
+ * for each dn limbs of the quotient; dn >= 4.
+ */
+limb_t div_qr_schoolbook(limb_t* qp, limb_t* np, size_t nn, const limb_t* dp, size_t dn);
+limb_t div_qr_dc(limb_t* qp, limb_t* np, size_t nn, const limb_t* dp, size_t dn);
+
+/**
+ * {qp, nn - dn + 1} = {np, nn} / {dp, dn}, for a `d` that divides `n` (otherwise, the result is meaningless), with
+ * nn >= dn >= 1 and no leading zeroes in `d`. `qp` must not overlap anything.
+ *
+ * Jebelean's exact division: the quotient is found from the bottom up, each limb of it by multiplying the lowest limb
+ * of what's left by the inverse of d's lowest one modulo B. As the top limbs of the remainder are known to vanish, only
+ * the low nn - dn + 1 limbs of it are ever computed, which makes it much cheaper than `divrem` for short quotients.
+ */
+void divexact(limb_t* qp, const limb_t* np, size_t nn, const limb_t* dp, size_t dn);
+
+/*
+ * Montgomery multiplication: {rp, n} = {ap, n} * {bp, n} * B^-n mod {mp, n}
+ *
+ * For an odd `m` and a, b < m, with `m_inv` being -m^-1 mod B. `rp` may coincide with either operand.
+ *
+ * The reduction doesn't branch on the data, and neither do the basecase and IFMA products; the subquadratic ones do,
+ * and `mul` and `sqr` pick those from 32 limbs on (2048 bits) without IFMA. Whatever works with secrets goes through
+ * the `_sec` ones, which never leave the basecase and IFMA products.
+ */
+
+// {rp, n} = {tp, 2 * n} * B^-n mod {mp, n} for {tp, 2 * n} < m * B^n, clobbering `tp`
+void redc(limb_t* rp, limb_t* tp, const limb_t* mp, size_t n, limb_t m_inv);
+
+// `mul_basecase` and `sqr_basecase` followed by `redc`, with 2 * n limbs of scratch at `tp`
+void mont_mul_basecase(limb_t* rp, const limb_t* ap, const limb_t* bp, const limb_t* mp, size_t n, limb_t m_inv,
+                       limb_t* tp);
+void mont_sqr_basecase(limb_t* rp, const limb_t* ap, const limb_t* mp, size_t n, limb_t m_inv, limb_t* tp);
+// IFMA_MIN_LIMBS <= n <= IFMA_MAX_LIMBS, same as with `mul_ifma`
+void mont_mul_ifma(limb_t* rp, const limb_t* ap, const limb_t* bp, const limb_t* mp, size_t n, limb_t m_inv);
+
+// The IFMA one where it applies, otherwise `mul` followed by `redc`; `tp` is as with `mont_mul_basecase`
+void mont_mul(limb_t* rp, const limb_t* ap, const limb_t* bp, const limb_t* mp, size_t n, limb_t m_inv, limb_t* tp);
+// Same as `mont_mul` for a = b, with `sqr` instead
+void mont_sqr(limb_t* rp, const limb_t* ap, const limb_t* mp, size_t n, limb_t m_inv, limb_t* tp);
+
+// Same as the two above with the basecase ones instead of `mul` and `sqr`
+void mont_mul_sec(limb_t* rp, const limb_t* ap, const limb_t* bp, const limb_t* mp, size_t n, limb_t m_inv,
+                  limb_t* tp);
+void mont_sqr_sec(limb_t* rp, const limb_t* ap, const limb_t* mp, size_t n, limb_t m_inv, limb_t* tp);
+
+/**
+ * The width of the windows of a power by an exponent of `n_bits`, as chosen by OpenSSL: each one more bit means half as
+ * many multiplications on the way, but twice as many powers of the base to compute beforehand.
+ */
+constexpr size_t power_window_bits(const size_t n_bits)
+{
+    return n_bits > 671 ? 6 : n_bits > 239 ? 5 : n_bits > 79 ? 4 : n_bits > 23 ? 3 : 1;
+}
+
+// The widest of those, for the tables sized beforehand
+constexpr size_t POWER_MAX_WINDOW = 6;
+
+/**
+ * Batched powers: as many independent powers modulo as many odd numbers of the same size as there are 64-bit lanes in
+ * an AVX-512 vector, one in each lane. The numbers are in radix 2^52 with the lanes' digits interleaved (digit i of
+ * lane l at i * POWER_BATCH_LANES + l), so that each IFMA instruction takes the same digit of every lane, and all of
+ * them take the same steps, by fixed windows. Unlike `mont_mul_ifma`, this pays off below IFMA_MIN_LIMBS too.
+ */
+constexpr size_t POWER_BATCH_LANES = 8;
+
+/**
+ * The fewest powers modulo numbers of `n` limbs worth a batch. Whatever the number of lanes in use, a batch costs about
+ * as much as 1.5 powers one by one at 512 bits, 1.7 at 768, 2 at 1024, 2.6 at 1536, 3.4 at 2048, 4.5 at 3072 and 5.4
+ * at 4096, so it takes one more than that to pay off.
+ */
+constexpr size_t power_batch_min_lanes(const size_t n)
+{
+    return n <= 12 ? 2 : n <= 24 ? 3 : n <= 32 ? 4 : n <= 48 ? 5 : 6;
+}
+
+/**
+ * {rp + l * n, n} = {xp + l * n, n}^{ep + l * en, en} mod {mp + l * n, n} for each lane l < POWER_BATCH_LANES, with odd
+ * moduli of n <= IFMA_MAX_LIMBS limbs (leading zeroes allowed).
+ *
+ * Mustn't be called unless the avx512_ifma kernels are supported.
+ */
+void power_batch_ifma(limb_t* rp, const limb_t* xp, const limb_t* ep, size_t en, const limb_t* mp, size_t n);
+
+}
+}
+
+#endif //RSA_PREP_MPN_HPP
@@ -2,11 +2,41 @@
 #ifndef RSA_PREP_PRIMES_HPP
 #define RSA_PREP_PRIMES_HPP
 
+#include <cstdint>
+#include <vector>
+
 #include "intbig_t.h"
 
 namespace isg
 {
 
+/**
+ * A number's residues modulo the small primes (the ones of P_SMALL_PRIMES), kept up to date as the number is stepped
+ * forward, which is all that sieving for primes takes.
+ *
+ * They are taken in a single pass over the number's limbs, modulo the products of as many consecutive primes as fit in
+ * a limb, each with its reciprocal computed once; the residues modulo the primes themselves come from those.
+ */
+class small_residues
+{
+    std::vector<uint32_t> rs;
+
+public:
+    // x >= 0
+    explicit small_residues(const intbig_t& x);
+
+    // The primes, in the order of the residues
+    static const std::vector<uint32_t>& primes();
+
+    const std::vector<uint32_t>& values() const { return rs; }
+
+    // Turns these into the residues of x + delta
+    void advance(uint32_t delta);
+
+    // Whether any of the primes divides the number
+    bool any_zero() const;
+};
+
 class prime_finder
 {
     bool print_feedback;
@@ -46,7 +76,40 @@ public:
 
     bool test_prime_mr(const intbig_t& n);
 
+    /**
+     * A Miller-Rabin test with a = 2 (a strong probable prime test to base 2), which takes `intbig_t::pow2_mod` rather
+     * than a full power. Not random, so it doesn't count towards `num_mr_checks`, but it's what throws out nearly all
+     * of the composites that get past the sieve.
+     */
+    static bool test_prime_sprp2(const intbig_t& n);
+
+    // Same for each of `ns`, with the powers batched by `intbig_t::power_mod_batch` if the kernels allow
+    static std::vector<bool> test_prime_sprp2(const std::vector<intbig_t>& ns);
+
+    /**
+     * The candidates that have none of the primes of P_SMALL_PRIMES for a factor, in their order.
+     *
+     * Rather than taking the GCD of each with P_SMALL_PRIMES, looks at their `small_residues`.
+     */
+    std::vector<intbig_t> screen_small_factors(const std::vector<intbig_t>& candidates) const;
+
+    // How many odd numbers from a random start `random_prime` sieves through before it draws another one
+    static constexpr size_t SIEVE_STEPS = 4096;
+
+    /**
+     * A random prime of exactly `n_bits`, at least 2: the first one after a random odd number of as many, unless it'd
+     * take more bits than that, in which case it's another number. Up to 10 bits, where the sieve would throw most or all
+     * of them out, it's any of them, found by trial division.
+     *
+     * The numbers on the way are sieved by their residues modulo the small primes, which take an addition each to step
+     * forward, so that only the ones that survive get to the Miller-Rabin tests, the base-2 one first. With the IFMA
+     * kernels, that one is taken for blocks of POWER_BATCH_LANES of them at once; otherwise for each as it turns up.
+     */
     intbig_t random_prime(size_t n_bits);
+
+private:
+    // The index of the first of `block` that passes all of the tests, or its size if none does
+    size_t find_prime(const std::vector<intbig_t>& block, size_t n_bits);
 };
 
 }
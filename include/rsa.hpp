@@ -7,6 +7,7 @@
 #include <string>
 
 #include "intbig_t.h"
+#include "montgomery_ctx.hpp"
 
 namespace isg {
 namespace rsa {
@@ -22,7 +23,10 @@ class key_pub
 {
     intbig_t e, n;
 
-    key_pub(intbig_t e, intbig_t n) : e(std::move(e)), n(std::move(n)) { }
+    // For the powers modulo `n`, computed once per key (an RSA modulus is odd)
+    montgomery_ctx n_ctx;
+
+    key_pub(intbig_t e, intbig_t n) : e(std::move(e)), n(std::move(n)), n_ctx(this->n) { }
 
 public:
     key_pub(const std::string& e_bytes, const std::string& n_bytes);
@@ -45,7 +49,9 @@ class key_priv
 {
     intbig_t d, n;
 
-    key_priv(intbig_t d, intbig_t n) : d(std::move(d)), n(std::move(n)) { }
+    montgomery_ctx n_ctx;
+
+    key_priv(intbig_t d, intbig_t n) : d(std::move(d)), n(std::move(n)), n_ctx(this->n) { }
 
 public:
     key_priv(const std::string& d_bytes, const std::string& n_bytes);
@@ -0,0 +1,65 @@
+
+#ifndef RSA_PREP_THREAD_POOL_HPP
+#define RSA_PREP_THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace isg
+{
+
+/**
+ * A fixed set of worker threads running batches of tasks.
+ *
+ * Batches may be nested: a task can run a batch of its own. The thread that runs a batch takes part in it, and while
+ * waiting for the other threads, picks up whatever tasks are queued, so the workers never all end up blocked.
+ *
+ * The tasks mustn't throw.
+ */
+class thread_pool
+{
+    struct batch
+    {
+        size_t n_left;
+    };
+
+    struct task
+    {
+        const std::function<void()>* f;
+        batch* b;
+    };
+
+    std::mutex mutex;
+    std::condition_variable changed;
+
+    std::deque<task> queue;
+    bool stopping = false;
+
+    std::vector<std::thread> workers;
+
+    void worker_loop();
+
+    // Runs the task (with the mutex unlocked) and marks it done
+    void run_task(std::unique_lock<std::mutex>& lock, const task& t);
+
+public:
+    explicit thread_pool(unsigned n_workers);
+    ~thread_pool();
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    // Runs all of the tasks and returns once they're done
+    void run(const std::vector<std::function<void()>>& tasks);
+
+    // The threads working on a batch: the workers plus the one calling `run`
+    unsigned n_threads() const { return unsigned(workers.size()) + 1; }
+};
+
+}
+
+#endif //RSA_PREP_THREAD_POOL_HPP
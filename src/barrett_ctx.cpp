@@ -0,0 +1,110 @@
+
+#include "barrett_ctx.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace isg
+{
+
+using mpn::limb_t;
+
+barrett_ctx::barrett_ctx(const intbig_t& m) : m(m), k(m.limbs.size())
+{
+    if(m.sign <= 0) {
+        throw std::logic_error("Barrett reduction needs a positive modulus");
+    }
+
+    // B^2k / m, of k + 2 limbs at most
+    std::vector<limb_t> b2k(2 * k + 1, 0);
+    b2k.back() = 1;
+
+    std::vector<limb_t> r(k);
+    mu.resize(k + 2);
+
+    mpn::divrem(mu.data(), r.data(), b2k.data(), b2k.size(), m.limbs.data(), k);
+
+    mu.resize(mpn::normalized_size(mu.data(), mu.size()));
+}
+
+void barrett_ctx::reduce_limbs(limb_t* rp, const limb_t* xp, size_t xn) const
+{
+    xn = mpn::normalized_size(xp, xn);
+
+    // Below B^(k - 1), so below m already
+    if(xn < k) {
+        std::copy(xp, xp + xn, rp);
+        std::fill(rp + xn, rp + k, 0);
+
+        return;
+    }
+
+    mpn::scratch_frame frame;
+
+    if(xn > 2 * k) {
+        limb_t* const qp = frame.alloc(xn - k + 1);
+
+        mpn::divrem(qp, rp, xp, xn, m.limbs.data(), k);
+
+        return;
+    }
+
+    /**
+     * q = floor(floor(x / B^(k - 1)) * mu / B^(k + 1)), then r = x - q * m, which is below 3 * m. Since it's known to be
+     * that small, only the low k + 1 limbs of either side are needed.
+     */
+    const size_t q1n = xn - (k - 1);
+    const size_t mun = mu.size();
+
+    limb_t* const q2 = frame.alloc(q1n + mun);
+    mpn::mul(q2, xp + (k - 1), q1n, mu.data(), mun);
+
+    const limb_t* const q3 = q2 + (k + 1);
+    const size_t q3n = mpn::normalized_size(q3, q1n + mun - (k + 1));
+
+    limb_t* const r = frame.alloc(k + 1);
+
+    const size_t x_low = std::min(xn, k + 1);
+    std::copy(xp, xp + x_low, r);
+    std::fill(r + x_low, r + k + 1, 0);
+
+    if(q3n != 0) {
+        limb_t* const qm = frame.alloc(q3n + k);
+        mpn::mul(qm, q3, q3n, m.limbs.data(), k);
+
+        // Modulo B^(k + 1), where the borrow goes
+        const size_t qm_low = std::min(q3n + k, k + 1);
+        mpn::sub(r, r, k + 1, qm, qm_low);
+    }
+
+    // At most two subtractions; r has a limb more than m, which has to be zero for r to be below it
+    while(r[k] != 0 || mpn::cmp(r, m.limbs.data(), k) >= 0) {
+        r[k] -= mpn::sub_n(r, r, m.limbs.data(), k);
+    }
+
+    std::copy(r, r + k, rp);
+}
+
+intbig_t barrett_ctx::reduce(const intbig_t& x) const
+{
+    if(x.sign < 0) {
+        throw std::logic_error("Barrett reduction of a negative number");
+    }
+
+    intbig_t r;
+    r.limbs.resize(k);
+
+    reduce_limbs(r.limbs.data(), x.limbs.data(), x.limbs.size());
+
+    r.limbs.resize(mpn::normalized_size(r.limbs.data(), k));
+    r.sign = r.limbs.empty() ? 0 : 1;
+
+    return r;
+}
+
+intbig_t barrett_ctx::mul_mod(const intbig_t& a, const intbig_t& b) const
+{
+    return a.times_mod(b, *this);
+}
+
+}
@@ -0,0 +1,65 @@
+
+#include "cpu_features.hpp"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <cpuid.h>
+#define ISG_HAVE_CPUID 1
+#endif
+
+namespace isg
+{
+
+namespace
+{
+#ifdef ISG_HAVE_CPUID
+    /**
+     * Whether the OS has enabled saving the state of the AVX-512 registers: the opmask, the upper halves of ZMM0-15
+     * and ZMM16-31, as well as the SSE and AVX ones
+     */
+    bool os_saves_zmm()
+    {
+        unsigned eax, ebx, ecx, edx;
+
+        // OSXSAVE: XGETBV is available
+        if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || ((ecx >> 27) & 1) == 0) {
+            return false;
+        }
+
+        unsigned xcr0_low, xcr0_high;
+        asm("xgetbv" : "=a"(xcr0_low), "=d"(xcr0_high) : "c"(0));
+
+        return (xcr0_low & 0xE6) == 0xE6;
+    }
+#endif
+
+    cpu_features detect()
+    {
+        cpu_features features;
+
+#ifdef ISG_HAVE_CPUID
+        unsigned eax, ebx, ecx, edx;
+
+        // Leaf 7, sub-leaf 0: structured extended features
+        if(__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+            features.bmi2 = (ebx >> 8) & 1;
+            features.adx = (ebx >> 19) & 1;
+
+            if(os_saves_zmm()) {
+                features.avx512f = (ebx >> 16) & 1;
+                features.avx512ifma = (ebx >> 21) & 1;
+            }
+        }
+#endif
+
+        return features;
+    }
+}
+
+const cpu_features& cpu_features::get()
+{
+    static const cpu_features features = detect();
+
+    return features;
+}
+
+}
@@ -6,6 +6,14 @@
 #include <sstream> // TODO!: remove?
 #include <random>
 
+#include "mpn.hpp"
+#include "barrett_ctx.hpp"
+#include "montgomery_ctx.hpp"
+#include "modint.hpp"
+
+using isg::mpn::limb_t;
+using isg::mpn::power_window_bits;
+
 /*
  * TODO: decide how much to reserve
  *       (i.e. how much bytes will we need and how much to pass to "reverse" to achieve that amount)
@@ -18,7 +26,7 @@
  */
 constexpr size_t INITIAL_RESERVATION = 20;
 
-intbig_t::intbig_t(int sign, std::vector<uint64_t>&& limbs) : sign(sign), limbs(limbs)
+intbig_t::intbig_t(int sign, std::vector<uint64_t>&& limbs) : sign(sign), limbs(std::move(limbs))
 {
     this->limbs.reserve(INITIAL_RESERVATION);
 }
@@ -120,13 +128,24 @@ std::string intbig_t::to_string(const Base base) const
             return "0";
         }
 
-        // TODO: consider reducing the number of divisions by taking up to 18 digits at a time
+        // 19 digits at a time, as 10^19 is the largest power of ten below 2^64
+        const isg::mpn::divisor_1 chunk_base(10000000000000000000ULL);
 
-        intbig_t value = *this;
+        std::vector<uint64_t> value = limbs;
         std::string s;
 
-        while(value != 0) {
-            s += (char)('0' + value.divmod(10));
+        while(!value.empty()) {
+            uint64_t chunk = isg::mpn::divrem_1(value.data(), value.data(), value.size(), chunk_base);
+
+            if(!value.back()) {
+                value.pop_back();
+            }
+
+            // All the chunks are zero-padded but the top one
+            for(int i = 0; i < 19 && (chunk != 0 || !value.empty()); i++) {
+                s += char('0' + chunk % 10);
+                chunk /= 10;
+            }
         }
 
         if(sign < 0) {
@@ -296,14 +315,17 @@ std::vector<uint64_t> random_bits_upto(size_t n_bits)
 
 intbig_t intbig_t::random_bits(size_t n_bits)
 {
+    if(!n_bits) {
+        return intbig_t();
+    }
+
     auto limbs = random_bits_upto(n_bits);
 
-    if(n_bits) {
-        // REVIEW: Why doesn't this work with (n_bits % 64 - 1)?..
-        limbs.back() |= (1 << (n_bits % 64));
-    }
+    // The top limbs may have come out zero, and the top bit is set either way
+    limbs.resize((n_bits + 63) / 64);
+    limbs.back() |= uint64_t(1) << ((n_bits - 1) % 64);
 
-    return { limbs.empty() ? 0 : 1, std::move(limbs) };
+    return { 1, std::move(limbs) };
 }
 
 intbig_t intbig_t::random_lte(const intbig_t& x_max)
@@ -390,26 +412,7 @@ int intbig_t::compare_3way_unsigned(const intbig_t& other) const
         return 1;
     }
 
-    // From most significant to least significant
-    for(ssize_t i = limbs.size() - 1; i >= 0; i--) {
-        /*
-         * Can't simply return a - b here -- it may not fit neither int nor int64_t
-         */
-
-        // REVIEW: const uint64_t&
-        // REVIEW: a way to make their signed difference fit some type?
-        const uint64_t our_limb = limbs[i];
-        const uint64_t their_limb = other.limbs[i];
-
-        if(our_limb < their_limb) {
-            return -1;
-        }
-        else if(our_limb > their_limb) {
-            return 1;
-        }
-    }
-
-    return 0;
+    return isg::mpn::cmp(limbs.data(), other.limbs.data(), limbs.size());
 }
 
 int intbig_t::compare_3way(const intbig_t& other) const
@@ -501,32 +504,31 @@ intbig_t& intbig_t::negate()
 }
 
 namespace {
-    void add2_unsigned(std::vector<uint64_t>& acc, uint64_t x)
+    // Drop the leading zero limbs, if any
+    void normalize(std::vector<uint64_t>& limbs)
     {
-        for(size_t i = 0; x && i < acc.size(); i++) {
-            const uint64_t new_limb = acc[i] + x;
-
-            x = new_limb <= acc[i] ? 1 : 0;
+        limbs.resize(isg::mpn::normalized_size(limbs.data(), limbs.size()));
+    }
 
-            acc[i] = new_limb;
-        }
+    void add2_unsigned(std::vector<uint64_t>& acc, uint64_t x)
+    {
+        const limb_t carry = isg::mpn::add_1(acc.data(), acc.data(), acc.size(), x);
 
-        if(x) {
-            acc.push_back(x);
+        if(carry) {
+            acc.push_back(carry);
         }
     }
 
     void sub2_unsigned(std::vector<uint64_t>& acc, uint64_t x)
     {
-        for(size_t i = 0; x && i < acc.size(); i++) {
-            const uint64_t new_limb = acc[i] - x;
-
-            x = new_limb >= acc[i] ? 1 : 0;
+        /*
+         * Pre: acc >= x
+         */
 
-            acc[i] = new_limb;
-        }
+        isg::mpn::sub_1(acc.data(), acc.data(), acc.size(), x);
 
-        if(!acc.back()) {
+        // Subtracting a single limb can only zero out the top one
+        if(!acc.empty() && !acc.back()) {
             acc.pop_back();
         }
     }
@@ -572,9 +574,11 @@ intbig_t& intbig_t::operator-=(const int64_t x)
     else {
         auto _x = (uint64_t)x;
 
-        if(limbs.size() == 1 && limbs[0] < _x) {
+        if(limbs.size() <= 1 && (limbs.empty() ? 0 : limbs[0]) < _x) {
+            // Crossing zero (possibly from zero itself), so compute x - this instead
+            limbs.resize(1);
             std::swap(limbs[0], _x);
-            negate();
+            sign = -1;
         }
 
         sub2_unsigned(limbs, _x);
@@ -611,40 +615,19 @@ namespace {
         /*
          * In-place add the two unsigned big integers:
          *   acc = acc + x
+         *
+         * Works for when `acc` and `x` is actually the same vector as well.
          */
 
         if(acc.size() < x.size()) {
             acc.resize(x.size());
         }
 
-        bool carry = false;
-
-        for(size_t i = 0; i < x.size(); i++) {
-            // In case acc and x is actually the same vector
-            // REVIEW: either find a way to avoid this copy or apply the hack to subs as well
-            const uint64_t x_limb = x[i];
-
-            acc[i] += x[i] + carry;
-
-            // Set carry if overflow occured
-            if(!carry) {
-                carry = acc[i] < x_limb;
-            }
-            else {
-                carry = acc[i] <= x_limb;
-            }
-        }
-
-        // Propagate the carry, if any, through the acc's higher digits
-        for(size_t i = x.size(); carry && i < acc.size(); i++) {
-            acc[i] += carry;
-
-            carry = (acc[i] == 0);
-        }
+        const limb_t carry = isg::mpn::add(acc.data(), acc.data(), acc.size(), x.data(), x.size());
 
         // potentially reaching a power of 64
         if(carry) {
-            acc.push_back(1);
+            acc.push_back(carry);
         }
     }
 
@@ -655,9 +638,6 @@ namespace {
          *   acc = acc - x
          *
          * Pre: acc >= x
-         *
-         * NOTE: while the two versions of this method look like they can be easily refactored into one, they actually
-         * have very little in common, so the result would consist completely of ifs.
          */
 
 #ifndef NDEBUG
@@ -666,44 +646,17 @@ namespace {
         }
 #endif
 
-        bool carry = false;
-
-        for(size_t i = 0; i < x.size(); i++) {
-            uint64_t acc_limb = acc[i] - carry - x[i];
-
-            // Set carry if overflow has occurred
-            if(!carry) {
-                carry = acc_limb > acc[i];
-            }
-            else {
-                carry = acc_limb >= acc[i];
-            }
-
-            acc[i] = acc_limb;
-        }
-
-        // Collect the remaining carry, if any
-        for(size_t i = x.size(); carry; i++) {
-#ifndef NDEBUG
-            if(i == acc.size()) {
-                break;
-            }
-#endif
-            acc[i] -= carry;
-
-            carry = (acc[i] == UINT64_MAX);
-        }
+        const limb_t borrow = isg::mpn::sub(acc.data(), acc.data(), acc.size(), x.data(), x.size());
 
 #ifndef NDEBUG
-        if(carry) {
+        if(borrow) {
             throw std::logic_error("Runaway carry -- this should't happen");
         }
+#else
+        (void)borrow;
 #endif
 
-        // REVIEW: can't this be done better (maintaining a variable through both loops doesn't seem like it)
-        while(!acc.empty() && acc.back() == 0) {
-            acc.pop_back();
-        }
+        normalize(acc);
     }
 
     void sub2from_unsigned(std::vector<uint64_t>& acc, const std::vector<uint64_t>& x)
@@ -721,37 +674,20 @@ namespace {
         }
 #endif
 
-        bool carry = false;
-
-        for(size_t i = 0; i < acc.size(); i++) {
-            uint64_t limb = x[i] - acc[i] - carry;
+        // Pad `acc` with zeroes so that the two can be subtracted limb-wise
+        acc.resize(x.size());
 
-            if(!carry) {
-                carry = limb > x[i];
-            }
-            else {
-                carry = limb >= x[i];
-            }
-
-            acc[i] = limb;
-        }
-
-        for(size_t i = acc.size(); i < x.size(); i++) {
-            acc.push_back(x[i] - carry);
-
-            carry = carry && (acc[i] == UINT64_MAX);
-        }
+        const limb_t borrow = isg::mpn::sub_n(acc.data(), x.data(), acc.data(), x.size());
 
 #ifndef NDEBUG
-        if(carry) {
+        if(borrow) {
             throw std::logic_error("Runaway carry -- this should't happen");
         }
+#else
+        (void)borrow;
 #endif
 
-        // REVIEW: see the other method
-        while(!acc.empty() && acc.back() == 0) {
-            acc.pop_back();
-        }
+        normalize(acc);
     }
 }
 
@@ -1001,34 +937,27 @@ intbig_t& intbig_t::operator<<=(const int64_t n)
 
     // REVIEW: rename to avoid Vietnam flashbacks?
     const uint64_t n_whole_limbs = (uint64_t)n / 64;
+    const auto this_n = unsigned((uint64_t)n % 64);
 
-    if(n_whole_limbs != 0) {
-        /*
-         * Add an `n_whole_limbs`-long section of zeroes to the back, then move it to the front:
-         *   ABC...XYZ --> ABC...XYZ[000] --> [000]ABC...XYZ
-         */
-        limbs.resize(limbs.size() + n_whole_limbs);
-        std::rotate(limbs.begin(), limbs.end() - n_whole_limbs, limbs.end());
-    }
-
-    const uint64_t this_n = (uint64_t)n % 64;
+    const size_t old_size = limbs.size();
 
-    if(this_n != 0) {
-        const uint64_t other_n = 64 - this_n;
+    // Room for the whole limbs at the bottom and the bits "ascending" out of the top
+    limbs.resize(old_size + n_whole_limbs + 1);
 
-        if(limbs.back() >> other_n != 0) {
-            limbs.push_back(0);
-        }
+    uint64_t* const p = limbs.data();
 
-        for(size_t i = limbs.size() - 1; i > n_whole_limbs; i--) {
-            /*
-             * Shift this limb while accepting the lower neighbour's highest bits "ascending up".
-             */
+    if(this_n != 0) {
+        p[old_size + n_whole_limbs] = isg::mpn::lshift(p + n_whole_limbs, p, old_size, this_n);
+    }
+    else {
+        std::copy_backward(p, p + old_size, p + old_size + n_whole_limbs);
+        p[old_size + n_whole_limbs] = 0;
+    }
 
-            limbs[i] = (limbs[i] << this_n) | (limbs[i - 1] >> other_n);
-        }
+    std::fill(p, p + n_whole_limbs, 0);
 
-        limbs[n_whole_limbs] <<= this_n;
+    if(!limbs.back()) {
+        limbs.pop_back();
     }
 
     return *this;
@@ -1066,46 +995,37 @@ intbig_t& intbig_t::operator>>=(const int64_t n)
 
             return *this; // TODO: <-- rearrange stuff so that there's only one of this statement
         }
-
-        /*
-         * Move an `n_whole_limbs`-long section from the front to the back, then cut it off:
-         *   [ABC]DEF...XYZ --> DEF...XYZ[ABC] --> DEF...XYZ
-         */
-        std::rotate(limbs.begin(), limbs.begin() + n_whole_limbs, limbs.end());
-        limbs.resize(limbs.size() - n_whole_limbs);
     }
 
-    // 2. Shift stuff along limb borders
-    uint64_t this_n = (uint64_t)n % 64;
-
-    if(this_n != 0) {
-        const uint64_t other_n = 64 - this_n;
+    // 2. Shift the remaining limbs down, along with the stuff along limb borders
+    const auto this_n = unsigned((uint64_t)n % 64);
+    const size_t new_size = limbs.size() - n_whole_limbs;
 
-        for(size_t i = 0; i < limbs.size() - 1; i++) {
-            /*
-             * Shift this limb while accepting the upper neighbour's lowest bits being "passed down".
-             */
+    uint64_t* const p = limbs.data();
 
-            limbs[i] = (limbs[i] >> this_n) | (limbs[i + 1] << other_n);
-        }
+    if(this_n != 0) {
+        isg::mpn::rshift(p, p + n_whole_limbs, new_size, this_n);
+    }
+    else {
+        std::copy(p + n_whole_limbs, p + limbs.size(), p);
+    }
 
-        limbs.back() >>= this_n;
+    limbs.resize(new_size);
 
-        // TODO: somehow restructure this if into a prettier sight
-        if(limbs.back() == 0) {
-            if(limbs.size() == 1) {
-                if(sign == -1) {
-                    limbs[0] = 1;
-                }
-                else {
-                    limbs.pop_back();
-                    sign = 0;
-                }
+    // TODO: somehow restructure this if into a prettier sight
+    if(limbs.back() == 0) {
+        if(limbs.size() == 1) {
+            if(sign == -1) {
+                limbs[0] = 1;
             }
             else {
                 limbs.pop_back();
+                sign = 0;
             }
         }
+        else {
+            limbs.pop_back();
+        }
     }
 
     return *this;
@@ -1273,34 +1193,7 @@ intbig_t& intbig_t::operator*=(const int64_t x)
         return *this;
     }
 
-    uint64_t carry = 0;
-
-    for(uint64_t& limb : limbs) {
-        const uint64_t limb_low = limb & 0xFFFFFFFF;
-        const uint64_t limb_high = limb >> 32;
-        const uint64_t x_low = (uint64_t)x & 0xFFFFFFFF;
-        const uint64_t x_high = (uint64_t)x >> 32;
-
-        const uint64_t z0 = limb_low * x_low;
-
-        uint64_t z1 = limb_high * x_low;
-        const uint64_t z11 = limb_low * x_high;
-
-        uint64_t z2 = limb_high * x_high;
-
-        z1 += z0 >> 32;
-        z1 += z11;
-
-        if(z1 < z11) {
-            z2 += 1ULL << 32;
-        }
-
-        limb = (z1 << 32) + (z0 & 0xFFFFFFFF) + carry;
-
-        // TODO!: Invent a test vector where this fails without the (limb < carry) term.
-        //  Also, can't this expression itself carry?
-        carry = (limb < carry) + z2 + (z1 >> 32);
-    }
+    const limb_t carry = isg::mpn::mul_1(limbs.data(), limbs.data(), limbs.size(), (uint64_t)x);
 
     if(carry) {
         limbs.push_back(carry);
@@ -1315,36 +1208,42 @@ uint64_t intbig_t::divmod(const uint64_t x)
         throw std::domain_error("Division by zero");
     }
 
-    /**
-     * TODO: implement this the way GMP does it:
-     *  - https://gmplib.org/manual/Single-Limb-Division.html#Single-Limb-Division
-     *  - https://gmplib.org/~tege/division-paper.pdf
-     */
+    const uint64_t rem = isg::mpn::divrem_1(limbs.data(), limbs.data(), limbs.size(), isg::mpn::divisor_1(x));
 
-    uint64_t carry = 0;
+    normalize(limbs);
 
-    for(ssize_t i = limbs.size() - 1; i >= 0; i--) {
-        uint64_t limb_high = (carry << 32) + (limbs[i] >> 32);
+    if(limbs.empty()) {
+        sign = 0;
+    }
+
+    return rem;
+}
 
-        carry = limb_high % x;
-        limb_high /= x;
+uint64_t intbig_t::mod(const uint64_t x) const
+{
+    if(x == 0) {
+        throw std::domain_error("Division by zero");
+    }
 
-        uint64_t limb_low = (carry << 32) + (limbs[i] & 0xFFFFFFFF);
-        carry = limb_low % x;
-        limb_low /= x;
+    return isg::mpn::mod_1(limbs.data(), limbs.size(), isg::mpn::divisor_1(x));
+}
 
-        limbs[i] = (limb_high << 32) | (limb_low & 0xFFFFFFFF);
+std::vector<uint64_t> intbig_t::mod_each(const std::vector<intbig_t>& xs, const uint64_t x)
+{
+    if(x == 0) {
+        throw std::domain_error("Division by zero");
     }
 
-    if(!limbs.back()) {
-        limbs.pop_back();
+    const isg::mpn::divisor_1 d(x);
 
-        if(limbs.empty()) {
-            sign = 0;
-        }
+    std::vector<uint64_t> rems;
+    rems.reserve(xs.size());
+
+    for(const intbig_t& a : xs) {
+        rems.push_back(isg::mpn::mod_1(a.limbs.data(), a.limbs.size(), d));
     }
 
-    return carry;
+    return rems;
 }
 
 intbig_t& intbig_t::operator/=(const int64_t x)
@@ -1387,74 +1286,47 @@ int64_t intbig_t::operator%(const int64_t x) const
         throw std::logic_error("Not implemented yet");
     }
 
-    intbig_t x_div = *this;
-
-    return x_div.divmod((uint64_t)x);
+    return mod((uint64_t)x);
 }
 
-namespace
+intbig_t& intbig_t::operator*=(const intbig_t& other)
 {
-    /**
-     * Perform "full word" multiplication on limbs.
-     * TODO: use this in operator*=(uint64_t) as well
-     *
-     * @return Two-limb product of @code a and @code b
-     */
-    std::pair<uint64_t, uint64_t> mul_full(const uint64_t a, const uint64_t b)
-    {
-        const uint64_t a_low = a & 0xFFFFFFFF;
-        const uint64_t a_high = a >> 32;
-        const uint64_t b_low = b & 0xFFFFFFFF;
-        const uint64_t b_high = b >> 32;
-
-        const uint64_t z0 = a_low * b_low;
-
-        uint64_t z1 = a_high * b_low;
-        const uint64_t z11 = a_low * b_high;
-
-        uint64_t z2 = a_high * b_high;
-
-        z1 += z0 >> 32;
-        z1 += z11;
-
-        if(z1 < z11) {
-            z2 += 1ULL << 32;
-        }
+    if(!sign || !other.sign) {
+        // Keeping the buffer for whatever comes next
+        sign = 0;
+        limbs.clear();
 
-        return { (z1 << 32) + (z0 & 0xFFFFFFFF), z2 + (z1 >> 32) };
+        return *this;
+    }
+    else if(this == &other) {
+        return square();
+    }
+    else if(other == 1) {
+        return *this;
     }
 
-    void add1_at(std::vector<uint64_t>& acc, uint64_t x, const size_t i_radix)
-    {
-        if(acc.size() <= i_radix) {
-            acc.resize(i_radix + 1);
-        }
+    // The product can't be computed in place either, same as the square
+    isg::mpn::scratch_frame frame;
 
-        for(size_t i = i_radix; x && i < acc.size(); i++) {
-            acc[i] += x;
+    const size_t n = limbs.size();
+    limb_t* const operand = frame.alloc(n);
 
-            x = acc[i] < x ? 1 : 0;
-        }
+    std::copy(limbs.begin(), limbs.end(), operand);
+    limbs.resize(n + other.limbs.size());
 
-        if(x) {
-            acc.push_back(x);
-        }
-    }
-}
+    isg::mpn::mul(limbs.data(), operand, n, other.limbs.data(), other.limbs.size());
 
-intbig_t& intbig_t::operator*=(const intbig_t& other)
-{
-    if(other == 1) {
-        return *this;
+    if(!limbs.back()) {
+        limbs.pop_back();
     }
 
-    return operator=(operator*(other));
+    sign *= other.sign;
+
+    return *this;
 }
 
 intbig_t intbig_t::operator*(const intbig_t& other) const
 {
-    // TODO: Karatsuba for numbers over a threshold (30 limbs in GMP)
-
     if(!sign || !other.sign) {
         return intbig_t();
     }
@@ -1462,87 +1334,130 @@ intbig_t intbig_t::operator*(const intbig_t& other) const
         return other;
     }
 
-    std::vector<uint64_t> new_limbs(limbs.size() + other.limbs.size() - 1);
-
-    for(size_t i = 0; i < limbs.size(); i++) {
-        for(size_t j = 0; j < other.limbs.size(); j++) {
-            const auto prod = mul_full(limbs[i], other.limbs[j]);
+    std::vector<uint64_t> new_limbs(limbs.size() + other.limbs.size());
 
-            if(prod.first) {
-                add1_at(new_limbs, prod.first, i + j);
-            }
+    isg::mpn::mul(new_limbs.data(), limbs.data(), limbs.size(), other.limbs.data(), other.limbs.size());
 
-            if(prod.second) {
-                add1_at(new_limbs, prod.second, i + j + 1);
-            }
-        }
+    // The product of an m- and an n-limb numbers has either m + n or m + n - 1 limbs
+    if(!new_limbs.back()) {
+        new_limbs.pop_back();
     }
 
     return intbig_t(sign * other.sign, std::move(new_limbs));
 }
 
-intbig_t intbig_t::divmod(const intbig_t& other)
+namespace
 {
-    if(!sign) {
-        return intbig_t();
-    }
+    /**
+     * The quotient and the remainder of |n| / |d|, normalized, for n at least as long as d. Either of them can be left
+     * out, and either can go to `n` itself.
+     */
+    void divrem_unsigned(const std::vector<uint64_t>& n, const std::vector<uint64_t>& d,
+                         std::vector<uint64_t>* q, std::vector<uint64_t>* r)
+    {
+        isg::mpn::scratch_frame frame;
+
+        const size_t qn = n.size() - d.size() + 1;
+
+        limb_t* const qp = frame.alloc(qn);
+        limb_t* const rp = frame.alloc(d.size());
 
-    // TODO!: Handle negative signs and zeroes
+        isg::mpn::divrem(qp, rp, n.data(), n.size(), d.data(), d.size());
 
-    ssize_t n_bits_q = num_bits() - other.num_bits();
+        if(q != nullptr) {
+            q->assign(qp, qp + qn);
+            normalize(*q);
+        }
 
-    if(n_bits_q < 0) {
-        sign *= other.sign;
+        if(r != nullptr) {
+            r->assign(rp, rp + d.size());
+            normalize(*r);
+        }
+    }
+}
 
+intbig_t intbig_t::divmod(const intbig_t& other)
+{
+    if(!other.sign) {
+        throw std::domain_error("Division by zero");
+    }
+    else if(limbs.size() < other.limbs.size()) {
         intbig_t rem;
         std::swap(*this, rem);
 
         return rem;
     }
 
-    const int sign_q = sign * other.sign;
+    intbig_t rem;
 
-    intbig_t denom = other << n_bits_q;
+    divrem_unsigned(limbs, other.limbs, &limbs, &rem.limbs);
 
-    std::vector<uint64_t> limbs_q = std::vector<uint64_t>(size_t(n_bits_q) / 64 + 1, 0);
+    rem.sign = rem.limbs.empty() ? 0 : sign;
+    sign = limbs.empty() ? 0 : sign * other.sign;
 
-    for(ssize_t i = n_bits_q; i >= 0; i--) {
-        if(operator>=(denom)) {
-            sub2_unsigned(limbs, denom.limbs);
-
-            limbs_q[i / 64] |= 1ULL << (i % 64);
-        }
+    return rem;
+}
 
-        denom >>= 1;
+intbig_t& intbig_t::divexact(const intbig_t& other)
+{
+    if(!other.sign) {
+        throw std::domain_error("Division by zero");
     }
-
-    if(limbs.empty()) {
-        sign = 0;
+    else if(limbs.size() < other.limbs.size()) {
+        // Only zero is divisible by a longer number
+        return clear();
     }
 
-    /**
-     * TODO: Use correct sign for the resulting remainder
-     *  (while in principle remainder should always be non-negative, this may not apply to the one we get here)
-     *
-     * TODO: Sort out the exception that arises in ~std::vector if std::move(limbs_q) is used in this method (below
-     *  and at the top)
-     */
-    intbig_t rem{ limbs_q.empty() ? 0 : sign_q, limbs_q };
+    const size_t qn = limbs.size() - other.limbs.size() + 1;
 
-    std::swap(rem, *this);
+    isg::mpn::scratch_frame frame;
+    limb_t* const qp = frame.alloc(qn);
 
-    return rem;
+    isg::mpn::divexact(qp, limbs.data(), limbs.size(), other.limbs.data(), other.limbs.size());
+
+    limbs.assign(qp, qp + qn);
+    normalize(limbs);
+
+    sign = limbs.empty() ? 0 : sign * other.sign;
+
+    return *this;
 }
 
 intbig_t& intbig_t::operator/=(const intbig_t& other)
 {
-    divmod(other);
+    if(!other.sign) {
+        throw std::domain_error("Division by zero");
+    }
+    else if(limbs.size() < other.limbs.size()) {
+        sign = 0;
+        limbs.clear();
+
+        return *this;
+    }
+
+    divrem_unsigned(limbs, other.limbs, &limbs, nullptr);
+
+    sign = limbs.empty() ? 0 : sign * other.sign;
+
     return *this;
 }
 
 intbig_t& intbig_t::operator%=(const intbig_t& other)
 {
-    return operator=(divmod(other));
+    if(!other.sign) {
+        throw std::domain_error("Division by zero");
+    }
+    else if(limbs.size() < other.limbs.size()) {
+        return *this;
+    }
+
+    divrem_unsigned(limbs, other.limbs, nullptr, &limbs);
+
+    if(limbs.empty()) {
+        sign = 0;
+    }
+
+    return *this;
 }
 
 intbig_t intbig_t::operator/(const intbig_t& other) const
@@ -1573,47 +1488,184 @@ intbig_t& intbig_t::square()
         return *this;
     }
 
-    std::vector<uint64_t> new_limbs(2 * limbs.size() - 1);
-
     /**
-     * Only multiply limbs i and j once, but add double the product to the result.
+     * The square can't be computed in place, so the operand is copied out to the scratch arena. This way, once `limbs`
+     * has grown to the size, a loop of squarings doesn't allocate.
      */
-    for(size_t i = 0; i < limbs.size(); i++) {
-        for(size_t j = i; j < limbs.size(); j++) {
-            auto prod = mul_full(limbs[i], limbs[j]);
-            uint64_t prod_carry = 0;
-
-            if(i != j) {
-                prod_carry = prod.second >> 63;
-                prod.second = (prod.second << 1) | (prod.first >> 63);
-                prod.first <<= 1;
-            }
+    isg::mpn::scratch_frame frame;
 
-            if(prod.first) {
-                add1_at(new_limbs, prod.first, i + j);
-            }
+    const size_t n = limbs.size();
+    limb_t* const operand = frame.alloc(n);
 
-            if(prod.second) {
-                add1_at(new_limbs, prod.second, i + j + 1);
-            }
+    std::copy(limbs.begin(), limbs.end(), operand);
+    limbs.resize(2 * n);
 
-            if(prod_carry) {
-                add1_at(new_limbs, 1, i + j + 2);
-            }
-        }
-    }
+    isg::mpn::sqr(limbs.data(), operand, n);
 
-    limbs = new_limbs;
+    if(!limbs.back()) {
+        limbs.pop_back();
+    }
 
     return *this;
 }
 
-intbig_t& intbig_t::to_power(const intbig_t& pow)
+namespace
 {
-    return operator=(at_power(pow));
-}
-
-intbig_t intbig_t::at_power(const intbig_t& pow) const
+    /**
+     * A window of sliding-window exponentiation (HAC, algorithm 14.85): the exponent is split into windows of at most
+     * `window` bits that start and end with ones, with only squares for the zeroes between them, so that there's a
+     * multiplication per window rather than per set bit. Its value is 2 * j + 1, and it ends at bit `low`.
+     */
+    struct power_window
+    {
+        size_t low;
+        size_t j;
+
+        bool found;
+    };
+
+    // The window that starts at the highest set bit below `from`, if any
+    power_window next_power_window(const intbig_t& pow, const size_t window, const size_t from)
+    {
+        for(size_t i = from; i-- > 0; ) {
+            if(!pow.test_bit(i)) {
+                continue;
+            }
+
+            // The lowest set bit at most `window` bits down from `i` ends the window
+            size_t low = i + 1 > window ? i + 1 - window : 0;
+
+            while(!pow.test_bit(low)) {
+                low++;
+            }
+
+            size_t value = 0;
+
+            for(size_t j = i + 1; j-- > low; ) {
+                value = value << 1 | size_t(pow.test_bit(j));
+            }
+
+            return { low, value >> 1, true };
+        }
+
+        return { 0, 0, false };
+    }
+
+    /**
+     * Straus's simultaneous exponentiation with interleaved sliding windows (after Moeller): x_0^e_0 * x_1^e_1... with
+     * each exponent split into windows of its own, but all of them sharing a single chain of squares, with a
+     * multiplication wherever one of the windows ends.
+     *
+     * Over whatever numbers the callbacks work on: `set(t, j)` makes the result x_t^(2 * j + 1), `sqr()` squares it,
+     * and `mul(t, j)` multiplies it by x_t^(2 * j + 1). The odd powers of x_t up to x_t^(2^windows[t] - 1) are needed.
+     * At least one of the exponents must be non-zero.
+     *
+     * The windows are found on the way, so that what's allocated doesn't depend on the exponents.
+     */
+    template<typename Set, typename Sqr, typename Mul>
+    void power_interleaved(const std::vector<const intbig_t*>& pows, const std::vector<size_t>& windows,
+                           Set set, Sqr sqr, Mul mul)
+    {
+        // The next window of each exponent
+        std::vector<power_window> next(pows.size());
+        size_t n_bits = 0;
+
+        for(size_t t = 0; t < pows.size(); t++) {
+            next[t] = next_power_window(*pows[t], windows[t], pows[t]->num_bits());
+            n_bits = std::max(n_bits, pows[t]->num_bits());
+        }
+
+        bool started = false;
+
+        for(size_t i = n_bits; i-- > 0; ) {
+            // Squares of 1 until then
+            if(started) {
+                sqr();
+            }
+
+            for(size_t t = 0; t < pows.size(); t++) {
+                if(!next[t].found || next[t].low != i) {
+                    continue;
+                }
+
+                const size_t j = next[t].j;
+                next[t] = next_power_window(*pows[t], windows[t], i);
+
+                if(!started) {
+                    set(t, j);
+                    started = true;
+                }
+                else {
+                    mul(t, j);
+                }
+            }
+        }
+    }
+
+    // Same as the above for a single x^pow
+    template<typename Set, typename Sqr, typename Mul>
+    void power_sliding_window(const intbig_t& pow, const size_t window, Set set, Sqr sqr, Mul mul)
+    {
+        power_interleaved({ &pow }, { window },
+                          [&](size_t, const size_t j) { set(j); },
+                          sqr,
+                          [&](size_t, const size_t j) { mul(j); });
+    }
+
+    /**
+     * The fixed-window table of x^0...x^(2^window - 1) is stored interleaved, limb j of x^i at j * n_entries + i, so
+     * that the limbs of any one entry are spread over all the cache lines of the table (OpenSSL's scatter/gather).
+     */
+    void scatter_entry(limb_t* table, const size_t n_entries, const size_t k, const size_t i, const limb_t* xp)
+    {
+        for(size_t j = 0; j < k; j++) {
+            table[j * n_entries + i] = xp[j];
+        }
+    }
+
+    // Reads all of the table, keeping entry `i` by a mask rather than looking it up
+    void gather_entry(limb_t* rp, const limb_t* table, const size_t n_entries, const size_t k, const size_t i)
+    {
+        limb_t masks[64];
+
+        for(size_t e = 0; e < n_entries; e++) {
+            masks[e] = limb_t(0) - limb_t(e == i);
+        }
+
+        for(size_t j = 0; j < k; j++) {
+            const limb_t* const row = table + j * n_entries;
+            limb_t r = 0;
+
+            for(size_t e = 0; e < n_entries; e++) {
+                r |= row[e] & masks[e];
+            }
+
+            rp[j] = r;
+        }
+    }
+
+    // Bits [low, low + n) of {ep, en}, n < 64, with the ones past the end being zeroes
+    limb_t exponent_bits(const limb_t* ep, const size_t en, const size_t low, const size_t n)
+    {
+        const size_t i = low / 64;
+        const unsigned shift = unsigned(low % 64);
+
+        limb_t bits = ep[i] >> shift;
+
+        if(shift + n > 64 && i + 1 < en) {
+            bits |= ep[i + 1] << (64 - shift);
+        }
+
+        return bits & ((limb_t(1) << n) - 1);
+    }
+}
+
+intbig_t& intbig_t::to_power(const intbig_t& pow)
+{
+    return operator=(at_power(pow));
+}
+
+intbig_t intbig_t::at_power(const intbig_t& pow) const
 {
     if(pow.sign < 0) {
         throw std::logic_error("Can't raise to negative power " + pow.to_string());
@@ -1622,18 +1674,26 @@ intbig_t intbig_t::at_power(const intbig_t& pow) const
         return of(1);
     }
 
-    intbig_t result = of(1);
+    const size_t window = power_window_bits(pow.num_bits());
 
-    intbig_t pow2_this = *this;
+    // x, x^3, x^5...
+    std::vector<intbig_t> odd_powers(size_t(1) << (window - 1), *this);
 
-    for(size_t i = 0; i < pow.num_bits(); i++) {
-        if(pow.test_bit(i)) {
-            result *= pow2_this;
-        }
+    if(odd_powers.size() > 1) {
+        const intbig_t x2 = *this * *this;
 
-        pow2_this.square();
+        for(size_t j = 1; j < odd_powers.size(); j++) {
+            odd_powers[j] = odd_powers[j - 1] * x2;
+        }
     }
 
+    intbig_t result;
+
+    power_sliding_window(pow, window,
+                         [&](const size_t j) { result = odd_powers[j]; },
+                         [&] { result.square(); },
+                         [&](const size_t j) { result *= odd_powers[j]; });
+
     return result;
 }
 
@@ -1647,95 +1707,762 @@ intbig_t intbig_t::times_mod(const intbig_t& other, const intbig_t& m) const
     if(sign < 0 || other.sign < 0 || m.sign <= 0) {
         throw std::logic_error("");
     }
-    else if(!sign || !other.sign) {
-        // TODO: Do the modulo on operands before this check
 
-        return of(0);
+    // Not through `isg::modint`: a context costs a division to set up, which for a single product is all it saves
+    intbig_t result = operator*(other);
+    result %= m;
+
+    return result;
+}
+
+intbig_t& intbig_t::to_power(const intbig_t& pow, const intbig_t& m)
+{
+    return operator=(at_power(pow, m));
+}
+
+intbig_t intbig_t::at_power(const intbig_t& pow, const intbig_t& m) const
+{
+    if(sign < 0 || pow.sign < 0 || m.sign <= 0) {
+        throw std::logic_error("");
+    }
+    else if(!pow.sign) {
+        // Modulo 1, that's 0 too
+        return m == 1 ? intbig_t() : of(1);
+    }
+
+    // With a reduction per multiplication, setting up either one pays for itself right away
+    if(m.test_bit(0)) {
+        return at_power(pow, isg::montgomery_ctx(m));
     }
 
-    intbig_t result;
+    return at_power(pow, isg::barrett_ctx(m));
+}
 
-    intbig_t pow2_this = operator%(m);
-    const intbig_t m_other = other % m;
+intbig_t& intbig_t::mul_mod(const intbig_t& other, const isg::barrett_ctx& m)
+{
+    return operator=(times_mod(other, m));
+}
+
+intbig_t intbig_t::times_mod(const intbig_t& other, const isg::barrett_ctx& m) const
+{
+    if(sign < 0 || other.sign < 0) {
+        throw std::logic_error("");
+    }
 
-    for(size_t i = 0; i < other.num_bits(); i++) {
-        if(other.test_bit(i)) {
-            result += pow2_this;
+    const isg::modint<isg::barrett_ctx> a(m, *this);
 
-            if(result >= m) {
-                result -= m;
-            }
-        }
+    // Squares when `other` is this number itself
+    return (&other == this ? a.squared() : a * isg::modint<isg::barrett_ctx>(m, other)).value();
+}
+
+intbig_t& intbig_t::to_power(const intbig_t& pow, const isg::barrett_ctx& m)
+{
+    return operator=(at_power(pow, m));
+}
+
+intbig_t intbig_t::at_power(const intbig_t& pow, const isg::barrett_ctx& m) const
+{
+    if(sign < 0 || pow.sign < 0) {
+        throw std::logic_error("");
+    }
+    else if(!pow.sign) {
+        return m.modulus() == 1 ? intbig_t() : of(1);
+    }
+
+    const size_t k = m.size();
+
+    const size_t window = power_window_bits(pow.num_bits());
+    const size_t n_odd = size_t(1) << (window - 1);
+
+    isg::mpn::scratch_frame frame;
+
+    // x, x^3, x^5... mod m, each of k limbs
+    limb_t* const odd_powers = frame.alloc(n_odd * k);
+    m.reduce_limbs(odd_powers, limbs.data(), limbs.size());
 
-        pow2_this += pow2_this;
+    limb_t* const r = frame.alloc(k);
+    limb_t* const prod = frame.alloc(2 * k);
 
-        if(pow2_this >= m) {
-            pow2_this -= m;
+    if(n_odd > 1) {
+        isg::mpn::sqr(prod, odd_powers, k);
+        m.reduce_limbs(r, prod, 2 * k);
+
+        for(size_t j = 1; j < n_odd; j++) {
+            isg::mpn::mul(prod, odd_powers + (j - 1) * k, k, r, k);
+            m.reduce_limbs(odd_powers + j * k, prod, 2 * k);
         }
     }
 
+    power_sliding_window(pow, window,
+                         [&](const size_t j) {
+                             std::copy(odd_powers + j * k, odd_powers + (j + 1) * k, r);
+                         },
+                         [&] {
+                             isg::mpn::sqr(prod, r, k);
+                             m.reduce_limbs(r, prod, 2 * k);
+                         },
+                         [&](const size_t j) {
+                             isg::mpn::mul(prod, r, k, odd_powers + j * k, k);
+                             m.reduce_limbs(r, prod, 2 * k);
+                         });
+
+    intbig_t result;
+    result.limbs.assign(r, r + k);
+
+    normalize(result.limbs);
+    result.sign = result.limbs.empty() ? 0 : 1;
+
     return result;
 }
 
-intbig_t& intbig_t::to_power(const intbig_t& pow, const intbig_t& m)
+intbig_t& intbig_t::to_power(const intbig_t& pow, const isg::montgomery_ctx& m)
 {
     return operator=(at_power(pow, m));
 }
 
-intbig_t intbig_t::at_power(const intbig_t& pow, const intbig_t& m) const
+intbig_t intbig_t::at_power(const intbig_t& pow, const isg::montgomery_ctx& m) const
 {
-    if(sign < 0 || pow.sign < 0 || m.sign <= 0) {
+    if(sign < 0 || pow.sign < 0) {
         throw std::logic_error("");
     }
     else if(!pow.sign) {
-        return of(1);
+        return m.modulus() == 1 ? intbig_t() : of(1);
+    }
+
+    const size_t k = m.size();
+
+    const size_t window = power_window_bits(pow.num_bits());
+    const size_t n_odd = size_t(1) << (window - 1);
+
+    isg::mpn::scratch_frame frame;
+
+    // x, x^3, x^5... in Montgomery's form
+    limb_t* const odd_powers = frame.alloc(n_odd * k);
+    m.to_mont_limbs(odd_powers, limbs.data(), limbs.size());
+
+    limb_t* const r = frame.alloc(k);
+
+    if(n_odd > 1) {
+        m.sqr_limbs(r, odd_powers);
+
+        for(size_t j = 1; j < n_odd; j++) {
+            m.mul_limbs(odd_powers + j * k, odd_powers + (j - 1) * k, r);
+        }
+    }
+
+    power_sliding_window(pow, window,
+                         [&](const size_t j) { std::copy(odd_powers + j * k, odd_powers + (j + 1) * k, r); },
+                         [&] { m.sqr_limbs(r, r); },
+                         [&](const size_t j) { m.mul_limbs(r, r, odd_powers + j * k); });
+
+    intbig_t result;
+    result.limbs.resize(k);
+
+    m.from_mont_limbs(result.limbs.data(), r);
+
+    normalize(result.limbs);
+    result.sign = result.limbs.empty() ? 0 : 1;
+
+    return result;
+}
+
+intbig_t& intbig_t::to_power_sec(const intbig_t& pow, const isg::montgomery_ctx& m)
+{
+    return operator=(at_power_sec(pow, m));
+}
+
+intbig_t intbig_t::at_power_sec(const intbig_t& pow, const isg::montgomery_ctx& m) const
+{
+    if(sign < 0 || pow.sign < 0) {
+        throw std::logic_error("");
+    }
+    else if(!pow.sign) {
+        return m.modulus() == 1 ? intbig_t() : of(1);
+    }
+
+    const size_t k = m.size();
+
+    // All of the exponent's limbs, leading zeroes and all, so that only its length shows
+    const limb_t* const ep = pow.limbs.data();
+    const size_t en = pow.limbs.size();
+    const size_t n_bits = 64 * en;
+
+    const size_t window = power_window_bits(n_bits);
+    const size_t n_entries = size_t(1) << window;
+
+    isg::mpn::scratch_frame frame;
+
+    limb_t* const table = frame.alloc(n_entries * k);
+    limb_t* const x = frame.alloc(k);
+    limb_t* const t = frame.alloc(k);
+    limb_t* const r = frame.alloc(k);
+
+    // x^0 = R mod m, x^1, x^2... in Montgomery's form
+    const limb_t one = 1;
+    m.to_mont_limbs(t, &one, 1);
+    scatter_entry(table, n_entries, k, 0, t);
+
+    m.to_mont_limbs(x, limbs.data(), limbs.size());
+
+    for(size_t i = 1; i < n_entries; i++) {
+        m.mul_limbs_sec(t, t, x);
+        scatter_entry(table, n_entries, k, i, t);
+    }
+
+    // The top window takes whatever bits are left over by the full ones below it
+    const size_t top = n_bits % window != 0 ? n_bits % window : window;
+    size_t low = n_bits - top;
+
+    gather_entry(r, table, n_entries, k, exponent_bits(ep, en, low, top));
+
+    while(low != 0) {
+        low -= window;
+
+        for(size_t j = 0; j < window; j++) {
+            m.sqr_limbs_sec(r, r);
+        }
+
+        gather_entry(t, table, n_entries, k, exponent_bits(ep, en, low, window));
+        m.mul_limbs_sec(r, r, t);
+    }
+
+    intbig_t result;
+    result.limbs.resize(k);
+
+    m.from_mont_limbs(result.limbs.data(), r);
+
+    normalize(result.limbs);
+    result.sign = result.limbs.empty() ? 0 : 1;
+
+    return result;
+}
+
+intbig_t intbig_t::pow2_mod(const intbig_t& e, const intbig_t& m)
+{
+    if(e.sign < 0 || m.sign <= 0) {
+        throw std::logic_error("");
+    }
+
+    if(m.test_bit(0)) {
+        return pow2_mod(e, isg::montgomery_ctx(m));
+    }
+
+    return of(2).at_power(e, m);
+}
+
+intbig_t intbig_t::pow2_mod(const intbig_t& e, const isg::montgomery_ctx& m)
+{
+    if(e.sign < 0) {
+        throw std::logic_error("");
+    }
+    else if(!e.sign) {
+        return m.modulus() == 1 ? intbig_t() : of(1);
+    }
+
+    const size_t k = m.size();
+    const limb_t* const mp = m.modulus().limbs.data();
+
+    isg::mpn::scratch_frame frame;
+    limb_t* const r = frame.alloc(k);
+
+    // The top bit is set, so it starts at 2
+    const limb_t two = 2;
+    m.to_mont_limbs(r, &two, 1);
+
+    for(size_t i = e.num_bits() - 1; i-- > 0; ) {
+        m.sqr_limbs(r, r);
+
+        // Twice x * R is 2 * x in the form too, below 2 * m
+        if(e.test_bit(i)) {
+            const limb_t carry = isg::mpn::lshift(r, r, k, 1);
+
+            if(carry != 0 || isg::mpn::cmp(r, mp, k) >= 0) {
+                isg::mpn::sub_n(r, r, mp, k);
+            }
+        }
+    }
+
+    intbig_t result;
+    result.limbs.resize(k);
+
+    m.from_mont_limbs(result.limbs.data(), r);
+
+    normalize(result.limbs);
+    result.sign = result.limbs.empty() ? 0 : 1;
+
+    return result;
+}
+
+namespace
+{
+    /**
+     * The terms of a product of powers that aren't 1: their exponents and the widths of the windows for them, and where
+     * each one's odd powers go among those of all of them, k limbs apiece
+     */
+    struct power_terms_layout
+    {
+        std::vector<size_t> terms;
+        std::vector<const intbig_t*> pows;
+        std::vector<size_t> windows;
+        std::vector<size_t> offsets;
+
+        size_t total_limbs = 0;
+
+        power_terms_layout(const intbig_t::power_terms& ts, const size_t k)
+        {
+            for(size_t t = 0; t < ts.size(); t++) {
+                if(ts[t].first.sign < 0 || ts[t].second.sign < 0) {
+                    throw std::logic_error("");
+                }
+                else if(!ts[t].second.sign) {
+                    continue;
+                }
+
+                terms.push_back(t);
+                pows.push_back(&ts[t].second);
+                windows.push_back(power_window_bits(ts[t].second.num_bits()));
+                offsets.push_back(total_limbs);
+
+                total_limbs += (size_t(1) << (windows.back() - 1)) * k;
+            }
+        }
+    };
+}
+
+intbig_t intbig_t::multi_power_mod(const power_terms& terms, const intbig_t& m)
+{
+    if(m.sign <= 0) {
+        throw std::logic_error("");
+    }
+
+    if(m.test_bit(0)) {
+        return multi_power_mod(terms, isg::montgomery_ctx(m));
+    }
+
+    return multi_power_mod(terms, isg::barrett_ctx(m));
+}
+
+intbig_t intbig_t::multi_power_mod(const power_terms& terms, const isg::barrett_ctx& m)
+{
+    const size_t k = m.size();
+    const power_terms_layout layout(terms, k);
+
+    if(layout.pows.empty()) {
+        return m.modulus() == 1 ? intbig_t() : of(1);
     }
 
-    intbig_t result = of(1);
+    isg::mpn::scratch_frame frame;
+
+    // x_t, x_t^3, x_t^5... mod m for each of the terms in turn
+    limb_t* const odd_powers = frame.alloc(layout.total_limbs);
+
+    limb_t* const r = frame.alloc(k);
+    limb_t* const prod = frame.alloc(2 * k);
 
-    intbig_t pow2_this = operator%(m);
+    for(size_t t = 0; t < layout.pows.size(); t++) {
+        const intbig_t& x = terms[layout.terms[t]].first;
+        limb_t* const xs = odd_powers + layout.offsets[t];
 
-    for(size_t i = 0; i < pow.num_bits(); i++) {
-        if(pow.test_bit(i)) {
-            result *= pow2_this;
+        m.reduce_limbs(xs, x.limbs.data(), x.limbs.size());
 
-            if(result >= m) {
-                result %= m;
+        if(layout.windows[t] > 1) {
+            isg::mpn::sqr(prod, xs, k);
+            m.reduce_limbs(r, prod, 2 * k);
+
+            for(size_t j = 1; j < size_t(1) << (layout.windows[t] - 1); j++) {
+                isg::mpn::mul(prod, xs + (j - 1) * k, k, r, k);
+                m.reduce_limbs(xs + j * k, prod, 2 * k);
             }
         }
+    }
+
+    power_interleaved(layout.pows, layout.windows,
+                      [&](const size_t t, const size_t j) {
+                          const limb_t* const xs = odd_powers + layout.offsets[t] + j * k;
+
+                          std::copy(xs, xs + k, r);
+                      },
+                      [&] {
+                          isg::mpn::sqr(prod, r, k);
+                          m.reduce_limbs(r, prod, 2 * k);
+                      },
+                      [&](const size_t t, const size_t j) {
+                          isg::mpn::mul(prod, r, k, odd_powers + layout.offsets[t] + j * k, k);
+                          m.reduce_limbs(r, prod, 2 * k);
+                      });
+
+    intbig_t result;
+    result.limbs.assign(r, r + k);
 
-        pow2_this.square();
+    normalize(result.limbs);
+    result.sign = result.limbs.empty() ? 0 : 1;
 
-        if(pow2_this >= m) {
-            pow2_this %= m;
+    return result;
+}
+
+intbig_t intbig_t::multi_power_mod(const power_terms& terms, const isg::montgomery_ctx& m)
+{
+    const size_t k = m.size();
+    const power_terms_layout layout(terms, k);
+
+    if(layout.pows.empty()) {
+        return m.modulus() == 1 ? intbig_t() : of(1);
+    }
+
+    isg::mpn::scratch_frame frame;
+
+    // x_t, x_t^3, x_t^5... in Montgomery's form for each of the terms in turn
+    limb_t* const odd_powers = frame.alloc(layout.total_limbs);
+
+    limb_t* const r = frame.alloc(k);
+
+    for(size_t t = 0; t < layout.pows.size(); t++) {
+        const intbig_t& x = terms[layout.terms[t]].first;
+        limb_t* const xs = odd_powers + layout.offsets[t];
+
+        m.to_mont_limbs(xs, x.limbs.data(), x.limbs.size());
+
+        if(layout.windows[t] > 1) {
+            m.sqr_limbs(r, xs);
+
+            for(size_t j = 1; j < size_t(1) << (layout.windows[t] - 1); j++) {
+                m.mul_limbs(xs + j * k, xs + (j - 1) * k, r);
+            }
         }
     }
 
+    power_interleaved(layout.pows, layout.windows,
+                      [&](const size_t t, const size_t j) {
+                          const limb_t* const xs = odd_powers + layout.offsets[t] + j * k;
+
+                          std::copy(xs, xs + k, r);
+                      },
+                      [&] { m.sqr_limbs(r, r); },
+                      [&](const size_t t, const size_t j) {
+                          m.mul_limbs(r, r, odd_powers + layout.offsets[t] + j * k);
+                      });
+
+    intbig_t result;
+    result.limbs.resize(k);
+
+    m.from_mont_limbs(result.limbs.data(), r);
+
+    normalize(result.limbs);
+    result.sign = result.limbs.empty() ? 0 : 1;
+
     return result;
 }
 
-void euclid_ex(const intbig_t& a, const intbig_t& b, intbig_t& x, intbig_t& y)
+namespace
+{
+    /**
+     * The powers of `power_mod_batch` at the indices `is`, modulo numbers of the same size, in a single batch: there
+     * are POWER_BATCH_LANES at most, and the lanes left over repeat the first one.
+     */
+    void power_mod_lanes(std::vector<intbig_t>& rs, const std::vector<intbig_t>& xs, const std::vector<intbig_t>& pows,
+                         const std::vector<intbig_t>& ms, const std::vector<size_t>& is)
+    {
+        const size_t lanes = isg::mpn::POWER_BATCH_LANES;
+        const size_t n = ms[is[0]].limbs.size();
+
+        size_t en = 1;
+
+        for(const size_t i : is) {
+            en = std::max(en, pows[i].limbs.size());
+        }
+
+        isg::mpn::scratch_frame frame;
+
+        limb_t* const xp = frame.alloc(lanes * n);
+        limb_t* const ep = frame.alloc(lanes * en);
+        limb_t* const mp = frame.alloc(lanes * n);
+        limb_t* const rp = frame.alloc(lanes * n);
+
+        const auto pad = [](limb_t* dst, const std::vector<limb_t>& src, const size_t size) {
+            std::copy(src.begin(), src.end(), dst);
+            std::fill(dst + src.size(), dst + size, 0);
+        };
+
+        for(size_t l = 0; l < lanes; l++) {
+            const size_t i = is[l < is.size() ? l : 0];
+
+            pad(xp + l * n, xs[i].limbs.size() > n ? (xs[i] % ms[i]).limbs : xs[i].limbs, n);
+            pad(ep + l * en, pows[i].limbs, en);
+            pad(mp + l * n, ms[i].limbs, n);
+        }
+
+        isg::mpn::power_batch_ifma(rp, xp, ep, en, mp, n);
+
+        for(size_t l = 0; l < is.size(); l++) {
+            intbig_t& r = rs[is[l]];
+
+            r.limbs.assign(rp + l * n, rp + (l + 1) * n);
+            normalize(r.limbs);
+            r.sign = r.limbs.empty() ? 0 : 1;
+        }
+    }
+}
+
+std::vector<intbig_t> intbig_t::power_mod_batch(const std::vector<intbig_t>& xs, const std::vector<intbig_t>& pows,
+                                                const std::vector<intbig_t>& ms)
+{
+    if(xs.size() != pows.size() || xs.size() != ms.size()) {
+        throw std::logic_error("");
+    }
+
+    for(size_t i = 0; i < xs.size(); i++) {
+        if(xs[i].sign < 0 || pows[i].sign < 0 || ms[i].sign <= 0 || !ms[i].test_bit(0)) {
+            throw std::logic_error("");
+        }
+    }
+
+    std::vector<intbig_t> rs(xs.size());
+
+    const bool batched = isg::mpn::current_kernels() == isg::mpn::kernels::avx512_ifma;
+
+    // The indices waiting for a batch, by the size of the modulus
+    std::vector<std::vector<size_t>> pending(isg::mpn::IFMA_MAX_LIMBS + 1);
+
+    for(size_t i = 0; i < xs.size(); i++) {
+        const size_t n = ms[i].limbs.size();
+
+        if(!batched || n > isg::mpn::IFMA_MAX_LIMBS) {
+            rs[i] = xs[i].at_power(pows[i], ms[i]);
+            continue;
+        }
+
+        pending[n].push_back(i);
+
+        if(pending[n].size() == isg::mpn::POWER_BATCH_LANES) {
+            power_mod_lanes(rs, xs, pows, ms, pending[n]);
+            pending[n].clear();
+        }
+    }
+
+    // What's left over goes in partial batches if there's enough of it
+    for(size_t n = 0; n < pending.size(); n++) {
+        const std::vector<size_t>& is = pending[n];
+
+        if(is.size() >= isg::mpn::power_batch_min_lanes(n)) {
+            power_mod_lanes(rs, xs, pows, ms, is);
+            continue;
+        }
+
+        for(const size_t i : is) {
+            rs[i] = xs[i].at_power(pows[i], ms[i]);
+        }
+    }
+
+    return rs;
+}
+
+namespace
 {
-    if(a == 0) {
-        x = intbig_t::of(0);
-        y = intbig_t::of(1);
-        return;
+    // 64 bits of {xp, xn} from bit `low` up, with zeroes past its end
+    limb_t bits_at(const limb_t* xp, const size_t xn, const size_t low)
+    {
+        const size_t i = low / 64;
+        const unsigned shift = unsigned(low % 64);
+
+        limb_t bits = i < xn ? xp[i] >> shift : 0;
+
+        if(shift != 0 && i + 1 < xn) {
+            bits |= xp[i + 1] << (64 - shift);
+        }
+
+        return bits;
     }
 
-    intbig_t x_new, y_new;
-    euclid_ex(b % a, a, x_new, y_new);
+    /**
+     * The matrix of a Lehmer step (Knuth, TAOCP vol. 2, 4.5.2, algorithm L): u' = a * u + b * v and v' = c * u + d * v
+     * are that many steps of Euclid's algorithm down from u >= v, as many as their top bits `uh` and the same bits of v,
+     * `vh` (below 2^62), are sure to tell. A quotient is taken only if it's the same for all the values the bits cut
+     * off could make, which takes bounding both of u and v from above and below.
+     *
+     * The entries are below 2^62 in absolute value, with a and b of opposite signs (or a = 0), as are c and d. b = 0
+     * if not even the first quotient is certain.
+     */
+    struct lehmer_matrix
+    {
+        int64_t a, b, c, d;
+    };
+
+    lehmer_matrix lehmer_step(int64_t uh, int64_t vh)
+    {
+        lehmer_matrix mx = { 1, 0, 0, 1 };
+
+        while(true) {
+            const int64_t n1 = uh + mx.a, n2 = uh + mx.b;
+            const int64_t d1 = vh + mx.c, d2 = vh + mx.d;
+
+            // Past where the bounds are of any use, which the book only checks for zeroes in
+            if(n1 < 0 || n2 < 0 || d1 <= 0 || d2 <= 0) {
+                break;
+            }
+
+            const int64_t q = n1 / d1;
+
+            if(q == 0 || q != n2 / d2) {
+                break;
+            }
+
+            const int64_t c = mx.a - q * mx.c;
+            const int64_t d = mx.b - q * mx.d;
+            const int64_t r = uh - q * vh;
+
+            mx = { mx.c, mx.d, c, d };
+            uh = vh;
+            vh = r;
+        }
+
+        return mx;
+    }
+
+    limb_t abs_limb(const int64_t x)
+    {
+        return limb_t(x < 0 ? -x : x);
+    }
+
+    // {rp, n + 1} = a * {up, n} + b * {vp, n}, for a and b of opposite signs (or a = 0) and a non-negative result
+    void lehmer_combine(limb_t* rp, const int64_t a, const limb_t* up, const int64_t b, const limb_t* vp,
+                        const size_t n)
+    {
+        if(b > 0) {
+            rp[n] = isg::mpn::mul_1(rp, vp, n, abs_limb(b));
+            rp[n] -= isg::mpn::submul_1(rp, up, n, abs_limb(a));
+        }
+        else {
+            rp[n] = isg::mpn::mul_1(rp, up, n, abs_limb(a));
+            rp[n] -= isg::mpn::submul_1(rp, vp, n, abs_limb(b));
+        }
+    }
 
-    x = y_new - (b / a) * x_new;
-    y = x_new;
+    // {rp, n} = |a| * {up, n} + |b| * {vp, n}, known to fit
+    void lehmer_combine_abs(limb_t* rp, const int64_t a, const limb_t* up, const int64_t b, const limb_t* vp,
+                            const size_t n)
+    {
+        isg::mpn::mul_1(rp, up, n, abs_limb(a));
+        isg::mpn::addmul_1(rp, vp, n, abs_limb(b));
+    }
 }
 
 intbig_t intbig_t::inverse_mod(const intbig_t& m) const
 {
-    intbig_t x, y;
-    euclid_ex(*this, m, x, y);
+    if(m.sign <= 0) {
+        throw std::logic_error("");
+    }
+
+    /**
+     * Reduced first. Above m, the first quotient would be 0 and only swap them, so the coefficient comes out the same.
+     * A negative x is taken modulo m as well, so that its inverse is one (unlike that of the truncating recursion here
+     * before, which was off by the sign).
+     */
+    if(sign < 0 || *this > m) {
+        intbig_t x = *this % m;
+
+        if(x.sign < 0) {
+            x += m;
+        }
+
+        return x.inverse_mod(m);
+    }
+
+    /**
+     * Extended Euclid's algorithm on (u, v) = (m, x), iterative, with Lehmer's steps (see `lehmer_step`) taking about
+     * 30 quotients at a time in a pass over the numbers instead of a division apiece.
+     *
+     * Only the coefficients of x are kept track of, the one of u is w_u and that of v is w_v: these are of opposite
+     * signs, so each new one is the sum of the absolute values of the two terms, and only those are stored. Once v gets
+     * to 0, u is the gcd, and w_u is x^-1 mod m if that's 1.
+     */
+    const size_t k = m.limbs.size();
+
+    isg::mpn::scratch_frame frame;
+
+    // The remainders, and the next ones, each k limbs and one for the carries
+    limb_t* u = frame.alloc(k + 1);
+    limb_t* v = frame.alloc(k + 1);
+    limb_t* u_next = frame.alloc(k + 1);
+    limb_t* v_next = frame.alloc(k + 1);
+
+    // |w_u|, |w_v| and the next ones, which are never more than m
+    limb_t* wu = frame.alloc(k + 1);
+    limb_t* wv = frame.alloc(k + 1);
+    limb_t* wu_next = frame.alloc(k + 1);
+    limb_t* wv_next = frame.alloc(k + 1);
+
+    limb_t* const q = frame.alloc(k + 1);
+
+    std::copy(m.limbs.begin(), m.limbs.end(), u);
+    std::fill(u + k, u + k + 1, 0);
+
+    std::copy(limbs.begin(), limbs.end(), v);
+    std::fill(v + limbs.size(), v + k + 1, 0);
+
+    // m = 0 * x + 1 * m, x = 1 * x + 0 * m
+    std::fill(wu, wu + k + 1, 0);
+    std::fill(wv, wv + k + 1, 0);
+    wv[0] = 1;
+
+    // The sign of w_u, with w_v's being the opposite
+    int wu_sign = -1;
+
+    size_t un = k;
+    size_t vn = limbs.size();
+
+    while(vn != 0) {
+        const size_t u_bits = 64 * un - size_t(__builtin_clzll(u[un - 1]));
+        const size_t low = u_bits > 62 ? u_bits - 62 : 0;
+
+        const lehmer_matrix mx = lehmer_step(int64_t(bits_at(u, un, low)), int64_t(bits_at(v, vn, low)));
+
+        if(mx.b == 0) {
+            // A step of its own: (u, v) = (v, u mod v), and w_v = w_u - q * w_v
+            const size_t qn = un - vn + 1;
+
+            isg::mpn::divrem(q, u_next, u, un, v, vn);
+            std::fill(u_next + vn, u_next + k + 1, 0);
+
+            std::copy(wu, wu + k + 1, wv_next);
+
+            for(size_t i = 0; i < qn && i <= k; i++) {
+                isg::mpn::addmul_1(wv_next + i, wv, k + 1 - i, q[i]);
+            }
+
+            std::swap(u, v);
+            std::swap(v, u_next);
+            std::swap(wu, wv);
+            std::swap(wv, wv_next);
+
+            wu_sign = -wu_sign;
+        }
+        else {
+            lehmer_combine(u_next, mx.a, u, mx.b, v, un);
+            lehmer_combine(v_next, mx.c, u, mx.d, v, un);
+
+            lehmer_combine_abs(wu_next, mx.a, wu, mx.b, wv, k + 1);
+            lehmer_combine_abs(wv_next, mx.c, wu, mx.d, wv, k + 1);
+
+            std::swap(u, u_next);
+            std::swap(v, v_next);
+            std::swap(wu, wu_next);
+            std::swap(wv, wv_next);
+
+            // b * w_v is never 0, and has the sign of the new w_u
+            wu_sign = mx.b > 0 ? -wu_sign : wu_sign;
+        }
+
+        un = isg::mpn::normalized_size(u, un);
+        vn = isg::mpn::normalized_size(v, un);
+    }
+
+    intbig_t x;
+    x.limbs.assign(wu, wu + k + 1);
+
+    normalize(x.limbs);
+    x.sign = x.limbs.empty() ? 0 : wu_sign;
 
     if(x < 0) {
-        // REVIEW: Is this enough to get it out of the negatives?
         x += m;
     }
     else if(x >= m) {
@@ -0,0 +1,242 @@
+
+#include "modint.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace isg
+{
+
+using mpn::limb_t;
+
+namespace
+{
+    /*
+     * What differs between the contexts: the form the residues are kept in, and the product's reduction
+     */
+
+    // {rp, k} = {xp, xn} mod m
+    void to_form(const barrett_ctx& ctx, limb_t* rp, const limb_t* xp, size_t xn)
+    {
+        const size_t k = ctx.size();
+
+        xn = mpn::normalized_size(xp, xn);
+
+        // Most of the residues made are below m already
+        if(xn < k || (xn == k && mpn::cmp(xp, ctx.modulus().limbs.data(), k) < 0)) {
+            std::copy(xp, xp + xn, rp);
+            std::fill(rp + xn, rp + k, 0);
+        }
+        else {
+            ctx.reduce_limbs(rp, xp, xn);
+        }
+    }
+
+    void to_form(const montgomery_ctx& ctx, limb_t* rp, const limb_t* xp, const size_t xn)
+    {
+        ctx.to_mont_limbs(rp, xp, xn);
+    }
+
+    void from_form(const barrett_ctx& ctx, limb_t* rp, const limb_t* ap)
+    {
+        std::copy(ap, ap + ctx.size(), rp);
+    }
+
+    void from_form(const montgomery_ctx& ctx, limb_t* rp, const limb_t* ap)
+    {
+        ctx.from_mont_limbs(rp, ap);
+    }
+
+    // {rp, k} = {ap, k} * {bp, k} mod m, `rp` may coincide with the operands; squares when they're the same
+    void mul_form(const barrett_ctx& ctx, limb_t* rp, const limb_t* ap, const limb_t* bp)
+    {
+        const size_t k = ctx.size();
+
+        const size_t an = mpn::normalized_size(ap, k);
+        const size_t bn = mpn::normalized_size(bp, k);
+
+        if(an == 0 || bn == 0) {
+            std::fill(rp, rp + k, 0);
+
+            return;
+        }
+
+        mpn::scratch_frame frame;
+        limb_t* const prod = frame.alloc(an + bn);
+
+        mpn::mul(prod, ap, an, bp, bn);
+
+        ctx.reduce_limbs(rp, prod, an + bn);
+    }
+
+    void mul_form(const montgomery_ctx& ctx, limb_t* rp, const limb_t* ap, const limb_t* bp)
+    {
+        if(ap == bp) {
+            ctx.sqr_limbs(rp, ap);
+        }
+        else {
+            ctx.mul_limbs(rp, ap, bp);
+        }
+    }
+}
+
+template<typename Ctx>
+modint<Ctx>::modint(const Ctx& ctx) : ctx(&ctx), v(ctx.size(), 0) { }
+
+template<typename Ctx>
+modint<Ctx>::modint(const Ctx& ctx, const intbig_t& x) : modint(ctx)
+{
+    if(x.sign < 0) {
+        throw std::logic_error("A residue of a negative number");
+    }
+
+    to_form(ctx, v.data(), x.limbs.data(), x.limbs.size());
+}
+
+template<typename Ctx>
+void modint<Ctx>::check_ctx(const modint& other) const
+{
+    if(ctx != other.ctx) {
+        throw std::logic_error("Residues modulo different contexts");
+    }
+}
+
+template<typename Ctx>
+intbig_t modint<Ctx>::value() const
+{
+    intbig_t r;
+    r.limbs.resize(v.size());
+
+    from_form(*ctx, r.limbs.data(), v.data());
+
+    r.limbs.resize(mpn::normalized_size(r.limbs.data(), r.limbs.size()));
+    r.sign = r.limbs.empty() ? 0 : 1;
+
+    return r;
+}
+
+template<typename Ctx>
+modint<Ctx>& modint<Ctx>::operator+=(const modint& other)
+{
+    check_ctx(other);
+
+    const size_t k = v.size();
+    const limb_t* const mp = ctx->modulus().limbs.data();
+
+    // Below 2 * m, so a subtraction at most
+    const limb_t carry = mpn::add_n(v.data(), v.data(), other.v.data(), k);
+
+    if(carry != 0 || mpn::cmp(v.data(), mp, k) >= 0) {
+        mpn::sub_n(v.data(), v.data(), mp, k);
+    }
+
+    return *this;
+}
+
+template<typename Ctx>
+modint<Ctx>& modint<Ctx>::operator-=(const modint& other)
+{
+    check_ctx(other);
+
+    const size_t k = v.size();
+
+    if(mpn::sub_n(v.data(), v.data(), other.v.data(), k) != 0) {
+        mpn::add_n(v.data(), v.data(), ctx->modulus().limbs.data(), k);
+    }
+
+    return *this;
+}
+
+template<typename Ctx>
+modint<Ctx>& modint<Ctx>::operator*=(const modint& other)
+{
+    check_ctx(other);
+
+    mul_form(*ctx, v.data(), v.data(), other.v.data());
+
+    return *this;
+}
+
+template<typename Ctx>
+modint<Ctx> modint<Ctx>::operator+(const modint& other) const
+{
+    modint r = *this;
+
+    return r += other;
+}
+
+template<typename Ctx>
+modint<Ctx> modint<Ctx>::operator-(const modint& other) const
+{
+    modint r = *this;
+
+    return r -= other;
+}
+
+template<typename Ctx>
+modint<Ctx> modint<Ctx>::operator*(const modint& other) const
+{
+    check_ctx(other);
+
+    modint r(*ctx);
+    mul_form(*ctx, r.v.data(), v.data(), other.v.data());
+
+    return r;
+}
+
+template<typename Ctx>
+modint<Ctx>& modint<Ctx>::square()
+{
+    mul_form(*ctx, v.data(), v.data(), v.data());
+
+    return *this;
+}
+
+template<typename Ctx>
+modint<Ctx> modint<Ctx>::squared() const
+{
+    modint r(*ctx);
+    mul_form(*ctx, r.v.data(), v.data(), v.data());
+
+    return r;
+}
+
+template<typename Ctx>
+modint<Ctx> modint<Ctx>::pow(const intbig_t& e) const
+{
+    // The conversions are a couple of products against the power's thousands
+    return modint(*ctx, value().at_power(e, *ctx));
+}
+
+template<typename Ctx>
+modint<Ctx> modint<Ctx>::inverse() const
+{
+    const modint r(*ctx, value().inverse_mod(ctx->modulus()));
+
+    // `inverse_mod` doesn't tell when there's no inverse, but then the product isn't 1
+    if(r * *this != modint(*ctx, intbig_t::of(1))) {
+        throw std::logic_error("No inverse modulo a non-coprime modulus");
+    }
+
+    return r;
+}
+
+template<typename Ctx>
+bool modint<Ctx>::operator==(const modint& other) const
+{
+    check_ctx(other);
+
+    // Both are reduced, and in the same form
+    return v == other.v;
+}
+
+template<typename Ctx>
+bool modint<Ctx>::operator!=(const modint& other) const
+{
+    return !operator==(other);
+}
+
+template class modint<barrett_ctx>;
+template class modint<montgomery_ctx>;
+
+}
@@ -0,0 +1,201 @@
+
+#include "montgomery_ctx.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace isg
+{
+
+using mpn::limb_t;
+
+namespace
+{
+    // {rp, k} = {xp, xn} for xn <= k, padded with zeroes
+    void pad_limbs(limb_t* rp, const limb_t* xp, const size_t xn, const size_t k)
+    {
+        std::copy(xp, xp + xn, rp);
+        std::fill(rp + xn, rp + k, 0);
+    }
+
+    // The number of the k limbs at `x.limbs`
+    intbig_t& normalize_result(intbig_t& x)
+    {
+        x.limbs.resize(mpn::normalized_size(x.limbs.data(), x.limbs.size()));
+        x.sign = x.limbs.empty() ? 0 : 1;
+
+        return x;
+    }
+}
+
+montgomery_ctx::montgomery_ctx(const intbig_t& m) : m(m), k(m.limbs.size()), m_inv(0)
+{
+    if(m.sign <= 0 || !m.test_bit(0)) {
+        throw std::logic_error("Montgomery's reduction needs an odd positive modulus");
+    }
+
+    m_inv = -mpn::binvert_limb(m.limbs[0]);
+
+    // B^2k mod m
+    std::vector<limb_t> b2k(2 * k + 1, 0);
+    b2k.back() = 1;
+
+    std::vector<limb_t> q(k + 2);
+    r2.resize(k);
+
+    mpn::divrem(q.data(), r2.data(), b2k.data(), b2k.size(), m.limbs.data(), k);
+}
+
+void montgomery_ctx::to_mont_limbs(limb_t* rp, const limb_t* xp, size_t xn) const
+{
+    xn = mpn::normalized_size(xp, xn);
+
+    mpn::scratch_frame frame;
+    limb_t* const x = frame.alloc(k);
+
+    // Any x < B^k will do, as its product with R^2 mod m is below m * R
+    if(xn > k) {
+        limb_t* const qp = frame.alloc(xn - k + 1);
+
+        mpn::divrem(qp, x, xp, xn, m.limbs.data(), k);
+    }
+    else {
+        pad_limbs(x, xp, xn, k);
+    }
+
+    // On the kernels that don't branch on the data, as x may be a secret: it's a single product either way
+    mul_limbs_sec(rp, x, r2.data());
+}
+
+void montgomery_ctx::from_mont_limbs(limb_t* rp, const limb_t* ap) const
+{
+    mpn::scratch_frame frame;
+    limb_t* const tp = frame.alloc(2 * k);
+
+    pad_limbs(tp, ap, k, 2 * k);
+
+    mpn::redc(rp, tp, m.limbs.data(), k, m_inv);
+}
+
+void montgomery_ctx::mul_limbs(limb_t* rp, const limb_t* ap, const limb_t* bp) const
+{
+    mpn::scratch_frame frame;
+    limb_t* const tp = frame.alloc(2 * k);
+
+    mpn::mont_mul(rp, ap, bp, m.limbs.data(), k, m_inv, tp);
+}
+
+void montgomery_ctx::sqr_limbs(limb_t* rp, const limb_t* ap) const
+{
+    mpn::scratch_frame frame;
+    limb_t* const tp = frame.alloc(2 * k);
+
+    mpn::mont_sqr(rp, ap, m.limbs.data(), k, m_inv, tp);
+}
+
+void montgomery_ctx::mul_limbs_sec(limb_t* rp, const limb_t* ap, const limb_t* bp) const
+{
+    mpn::scratch_frame frame;
+    limb_t* const tp = frame.alloc(2 * k);
+
+    mpn::mont_mul_sec(rp, ap, bp, m.limbs.data(), k, m_inv, tp);
+}
+
+void montgomery_ctx::sqr_limbs_sec(limb_t* rp, const limb_t* ap) const
+{
+    mpn::scratch_frame frame;
+    limb_t* const tp = frame.alloc(2 * k);
+
+    mpn::mont_sqr_sec(rp, ap, m.limbs.data(), k, m_inv, tp);
+}
+
+intbig_t montgomery_ctx::to_mont(const intbig_t& x) const
+{
+    if(x.sign < 0) {
+        throw std::logic_error("Montgomery's form of a negative number");
+    }
+
+    intbig_t r;
+    r.limbs.resize(k);
+
+    to_mont_limbs(r.limbs.data(), x.limbs.data(), x.limbs.size());
+
+    return normalize_result(r);
+}
+
+intbig_t montgomery_ctx::from_mont(const intbig_t& x) const
+{
+    mpn::scratch_frame frame;
+    limb_t* const xp = frame.alloc(k);
+
+    pad_limbs(xp, x.limbs.data(), x.limbs.size(), k);
+
+    intbig_t r;
+    r.limbs.resize(k);
+
+    from_mont_limbs(r.limbs.data(), xp);
+
+    return normalize_result(r);
+}
+
+intbig_t montgomery_ctx::mul(const intbig_t& a, const intbig_t& b) const
+{
+    mpn::scratch_frame frame;
+    limb_t* const ap = frame.alloc(k);
+    limb_t* const bp = frame.alloc(k);
+
+    pad_limbs(ap, a.limbs.data(), a.limbs.size(), k);
+    pad_limbs(bp, b.limbs.data(), b.limbs.size(), k);
+
+    intbig_t r;
+    r.limbs.resize(k);
+
+    mul_limbs(r.limbs.data(), ap, bp);
+
+    return normalize_result(r);
+}
+
+intbig_t montgomery_ctx::sqr(const intbig_t& a) const
+{
+    mpn::scratch_frame frame;
+    limb_t* const ap = frame.alloc(k);
+
+    pad_limbs(ap, a.limbs.data(), a.limbs.size(), k);
+
+    intbig_t r;
+    r.limbs.resize(k);
+
+    sqr_limbs(r.limbs.data(), ap);
+
+    return normalize_result(r);
+}
+
+intbig_t montgomery_ctx::mul_mod(const intbig_t& a, const intbig_t& b) const
+{
+    if(a.sign < 0 || b.sign < 0) {
+        throw std::logic_error("Montgomery's product of a negative number");
+    }
+
+    // a * R and b give a * b, with a single conversion
+    intbig_t r;
+    r.limbs.resize(k);
+
+    mpn::scratch_frame frame;
+    limb_t* const bp = frame.alloc(k);
+
+    if(b.limbs.size() > k || (b.limbs.size() == k && mpn::cmp(b.limbs.data(), m.limbs.data(), k) >= 0)) {
+        limb_t* const qp = frame.alloc(b.limbs.size() - k + 1);
+
+        mpn::divrem(qp, bp, b.limbs.data(), b.limbs.size(), m.limbs.data(), k);
+    }
+    else {
+        pad_limbs(bp, b.limbs.data(), b.limbs.size(), k);
+    }
+
+    to_mont_limbs(r.limbs.data(), a.limbs.data(), a.limbs.size());
+    mul_limbs(r.limbs.data(), r.limbs.data(), bp);
+
+    return normalize_result(r);
+}
+
+}
@@ -0,0 +1,579 @@
+
+#include "mpn.hpp"
+
+#include <algorithm>
+#include <initializer_list>
+
+#include "cpu_features.hpp"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define ISG_MPN_X86_64_ASM 1
+#endif
+
+namespace isg {
+namespace mpn {
+
+size_t normalized_size(const limb_t* ap, size_t n)
+{
+    while(n != 0 && ap[n - 1] == 0) {
+        n -= 1;
+    }
+
+    return n;
+}
+
+int cmp(const limb_t* ap, const limb_t* bp, size_t n)
+{
+    // From most significant to least significant
+    while(n-- != 0) {
+        if(ap[n] != bp[n]) {
+            return ap[n] < bp[n] ? -1 : 1;
+        }
+    }
+
+    return 0;
+}
+
+limb_t add_1(limb_t* rp, const limb_t* ap, const size_t n, limb_t b)
+{
+    size_t i = 0;
+
+    for(; b && i < n; i++) {
+        const limb_t r = ap[i] + b;
+
+        b = r < b;
+        rp[i] = r;
+    }
+
+    // Once there's no carry, the rest is just a copy
+    if(rp != ap) {
+        std::copy(ap + i, ap + n, rp + i);
+    }
+
+    return b;
+}
+
+limb_t add_n(limb_t* rp, const limb_t* ap, const limb_t* bp, const size_t n)
+{
+    limb_t carry = 0;
+
+    for(size_t i = 0; i < n; i++) {
+        const limb_t a = ap[i];
+        const limb_t s = a + bp[i];
+        const limb_t r = s + carry;
+
+        // At most one of these can overflow
+        carry = limb_t(s < a) | limb_t(r < s);
+        rp[i] = r;
+    }
+
+    return carry;
+}
+
+limb_t add(limb_t* rp, const limb_t* ap, const size_t an, const limb_t* bp, const size_t bn)
+{
+    const limb_t carry = add_n(rp, ap, bp, bn);
+
+    return add_1(rp + bn, ap + bn, an - bn, carry);
+}
+
+limb_t sub_1(limb_t* rp, const limb_t* ap, const size_t n, limb_t b)
+{
+    size_t i = 0;
+
+    for(; b && i < n; i++) {
+        const limb_t a = ap[i];
+
+        rp[i] = a - b;
+        b = a < b;
+    }
+
+    if(rp != ap) {
+        std::copy(ap + i, ap + n, rp + i);
+    }
+
+    return b;
+}
+
+limb_t sub_n(limb_t* rp, const limb_t* ap, const limb_t* bp, const size_t n)
+{
+    limb_t borrow = 0;
+
+    for(size_t i = 0; i < n; i++) {
+        const limb_t a = ap[i];
+        const limb_t b = bp[i];
+        const limb_t d = a - b;
+
+        rp[i] = d - borrow;
+        borrow = limb_t(a < b) | limb_t(d < borrow);
+    }
+
+    return borrow;
+}
+
+limb_t sub(limb_t* rp, const limb_t* ap, const size_t an, const limb_t* bp, const size_t bn)
+{
+    const limb_t borrow = sub_n(rp, ap, bp, bn);
+
+    return sub_1(rp + bn, ap + bn, an - bn, borrow);
+}
+
+limb_t cnd_add_n(const limb_t cnd, limb_t* rp, const limb_t* ap, const limb_t* bp, const size_t n)
+{
+    const limb_t mask = limb_t(0) - limb_t(cnd != 0);
+    limb_t carry = 0;
+
+    for(size_t i = 0; i < n; i++) {
+        const limb_t a = ap[i];
+        const limb_t s = a + (bp[i] & mask);
+        const limb_t r = s + carry;
+
+        carry = limb_t(s < a) | limb_t(r < s);
+        rp[i] = r;
+    }
+
+    return carry;
+}
+
+namespace
+{
+    limb_t mul_1_portable(limb_t* rp, const limb_t* ap, const size_t n, const limb_t b)
+    {
+        limb_t carry = 0;
+
+        for(size_t i = 0; i < n; i++) {
+            const auto prod = mul_full(ap[i], b);
+
+            const limb_t low = prod.first + carry;
+
+            // The high half of a product is at most 2^64 - 2, so this can't overflow
+            carry = prod.second + (low < carry);
+            rp[i] = low;
+        }
+
+        return carry;
+    }
+
+    limb_t addmul_1_portable(limb_t* rp, const limb_t* ap, const size_t n, const limb_t b)
+    {
+        limb_t carry = 0;
+
+        for(size_t i = 0; i < n; i++) {
+            const auto prod = mul_full(ap[i], b);
+
+            const limb_t low = prod.first + carry;
+            limb_t high = prod.second + (low < carry);
+
+            const limb_t r = rp[i] + low;
+            high += r < low;
+
+            rp[i] = r;
+            carry = high;
+        }
+
+        return carry;
+    }
+
+    limb_t submul_1_portable(limb_t* rp, const limb_t* ap, const size_t n, const limb_t b)
+    {
+        limb_t borrow = 0;
+
+        for(size_t i = 0; i < n; i++) {
+            const auto prod = mul_full(ap[i], b);
+
+            const limb_t low = prod.first + borrow;
+            limb_t high = prod.second + (low < borrow);
+
+            const limb_t r = rp[i];
+            high += r < low;
+
+            rp[i] = r - low;
+            borrow = high;
+        }
+
+        return borrow;
+    }
+
+#ifdef ISG_MPN_X86_64_ASM
+    /*
+     * MULX leaves the flags alone, so the carries of adding up the products' halves (ADCX, through CF) and of adding
+     * them to the destination (ADOX, through OF) propagate along two chains that don't wait on each other.
+     *
+     * Two limbs per iteration, counting a negative index up to zero: JRCXZ is the only branch that doesn't touch the
+     * flags, hence the index in RCX.
+     */
+
+    limb_t mul_1_mulx_adx(limb_t* rp, const limb_t* ap, size_t n, const limb_t b)
+    {
+        limb_t carry = 0;
+
+        if(n % 2 != 0) {
+            const auto prod = mul_full(ap[0], b);
+
+            rp[0] = prod.first;
+            carry = prod.second;
+
+            rp += 1;
+            ap += 1;
+            n -= 1;
+        }
+
+        if(n == 0) {
+            return carry;
+        }
+
+        limb_t lo0, hi0, lo1, hi1;
+        auto i = -static_cast<ptrdiff_t>(n);
+
+        asm volatile(
+                "xor %k[lo0], %k[lo0]\n\t"
+                "1:\n\t"
+                "mulx (%[ap],%[i],8), %[lo0], %[hi0]\n\t"
+                "mulx 8(%[ap],%[i],8), %[lo1], %[hi1]\n\t"
+                "adcx %[carry], %[lo0]\n\t"
+                "adcx %[hi0], %[lo1]\n\t"
+                "mov %[lo0], (%[rp],%[i],8)\n\t"
+                "mov %[lo1], 8(%[rp],%[i],8)\n\t"
+                "mov %[hi1], %[carry]\n\t"
+                "lea 2(%[i]), %[i]\n\t"
+                "jrcxz 2f\n\t"
+                "jmp 1b\n"
+                "2:\n\t"
+                "mov $0, %k[lo0]\n\t"
+                "adcx %[lo0], %[carry]\n\t"
+                : [lo0] "=&r"(lo0), [hi0] "=&r"(hi0), [lo1] "=&r"(lo1), [hi1] "=&r"(hi1),
+                  [carry] "+&r"(carry), [i] "+&c"(i)
+                : [ap] "r"(ap + n), [rp] "r"(rp + n), "d"(b)
+                : "cc", "memory");
+
+        return carry;
+    }
+
+    limb_t addmul_1_mulx_adx(limb_t* rp, const limb_t* ap, size_t n, const limb_t b)
+    {
+        limb_t carry = 0;
+
+        if(n % 2 != 0) {
+            const auto prod = mul_full(ap[0], b);
+
+            rp[0] += prod.first;
+            carry = prod.second + (rp[0] < prod.first);
+
+            rp += 1;
+            ap += 1;
+            n -= 1;
+        }
+
+        if(n == 0) {
+            return carry;
+        }
+
+        limb_t lo0, hi0, lo1, hi1;
+        auto i = -static_cast<ptrdiff_t>(n);
+
+        asm volatile(
+                "xor %k[lo0], %k[lo0]\n\t"
+                "1:\n\t"
+                "mulx (%[ap],%[i],8), %[lo0], %[hi0]\n\t"
+                "mulx 8(%[ap],%[i],8), %[lo1], %[hi1]\n\t"
+                "adcx %[carry], %[lo0]\n\t"
+                "adox (%[rp],%[i],8), %[lo0]\n\t"
+                "adcx %[hi0], %[lo1]\n\t"
+                "adox 8(%[rp],%[i],8), %[lo1]\n\t"
+                "mov %[lo0], (%[rp],%[i],8)\n\t"
+                "mov %[lo1], 8(%[rp],%[i],8)\n\t"
+                "mov %[hi1], %[carry]\n\t"
+                "lea 2(%[i]), %[i]\n\t"
+                "jrcxz 2f\n\t"
+                "jmp 1b\n"
+                "2:\n\t"
+                // Both chains end in the high half of the last product, which can take them: the result is a limb
+                "mov $0, %k[lo0]\n\t"
+                "adcx %[lo0], %[carry]\n\t"
+                "adox %[lo0], %[carry]\n\t"
+                : [lo0] "=&r"(lo0), [hi0] "=&r"(hi0), [lo1] "=&r"(lo1), [hi1] "=&r"(hi1),
+                  [carry] "+&r"(carry), [i] "+&c"(i)
+                : [ap] "r"(ap + n), [rp] "r"(rp + n), "d"(b)
+                : "cc", "memory");
+
+        return carry;
+    }
+#endif
+
+    typedef limb_t (*kernel_1)(limb_t*, const limb_t*, size_t, limb_t);
+
+    struct kernel_table
+    {
+        kernels variant;
+
+        kernel_1 mul_1;
+        kernel_1 addmul_1;
+        kernel_1 submul_1;
+    };
+
+    constexpr kernel_table PORTABLE_KERNELS = {
+            kernels::portable, mul_1_portable, addmul_1_portable, submul_1_portable
+    };
+
+#ifdef ISG_MPN_X86_64_ASM
+    // There's nothing to gain with ADX in a subtraction, but `mul_full` is a single instruction here anyway
+    constexpr kernel_table MULX_ADX_KERNELS = {
+            kernels::mulx_adx, mul_1_mulx_adx, addmul_1_mulx_adx, submul_1_portable
+    };
+
+    // The IFMA products aren't in the table: `mul` and `mont_mul` check `current_kernels()` for them
+    constexpr kernel_table AVX512_IFMA_KERNELS = {
+            kernels::avx512_ifma, mul_1_mulx_adx, addmul_1_mulx_adx, submul_1_portable
+    };
+#endif
+
+    /*
+     * Starts out as the portable ones (statically initialized), and gets replaced with the best supported ones by a
+     * dynamic initializer -- code that runs before it, if any, still gets correct results.
+     */
+    kernel_table current = PORTABLE_KERNELS;
+
+    kernels best_supported()
+    {
+        for(const kernels k : { kernels::avx512_ifma, kernels::mulx_adx }) {
+            if(kernels_supported(k)) {
+                return k;
+            }
+        }
+
+        return kernels::portable;
+    }
+
+    const bool selected_at_startup = select_kernels(best_supported());
+}
+
+kernels current_kernels()
+{
+    return current.variant;
+}
+
+const char* kernels_name(const kernels k)
+{
+    switch(k) {
+        case kernels::portable:
+            return "portable";
+        case kernels::mulx_adx:
+            return "mulx_adx";
+        case kernels::avx512_ifma:
+            return "avx512_ifma";
+    }
+
+    return "unknown";
+}
+
+bool kernels_supported(const kernels k)
+{
+    switch(k) {
+        case kernels::portable:
+            return true;
+        case kernels::mulx_adx:
+#ifdef ISG_MPN_X86_64_ASM
+            return cpu_features::get().bmi2 && cpu_features::get().adx;
+#else
+            return false;
+#endif
+        case kernels::avx512_ifma:
+#ifdef ISG_MPN_X86_64_ASM
+            return kernels_supported(kernels::mulx_adx) && cpu_features::get().avx512f
+                   && cpu_features::get().avx512ifma;
+#else
+            return false;
+#endif
+    }
+
+    return false;
+}
+
+bool select_kernels(const kernels k)
+{
+    if(!kernels_supported(k)) {
+        return false;
+    }
+
+    switch(k) {
+        case kernels::portable:
+            current = PORTABLE_KERNELS;
+            break;
+        case kernels::mulx_adx:
+#ifdef ISG_MPN_X86_64_ASM
+            current = MULX_ADX_KERNELS;
+#endif
+            break;
+        case kernels::avx512_ifma:
+#ifdef ISG_MPN_X86_64_ASM
+            current = AVX512_IFMA_KERNELS;
+#endif
+            break;
+    }
+
+    return true;
+}
+
+limb_t mul_1(limb_t* rp, const limb_t* ap, const size_t n, const limb_t b)
+{
+    return current.mul_1(rp, ap, n, b);
+}
+
+limb_t addmul_1(limb_t* rp, const limb_t* ap, const size_t n, const limb_t b)
+{
+    return current.addmul_1(rp, ap, n, b);
+}
+
+limb_t submul_1(limb_t* rp, const limb_t* ap, const size_t n, const limb_t b)
+{
+    return current.submul_1(rp, ap, n, b);
+}
+
+limb_t binvert_limb(const limb_t d)
+{
+    /**
+     * Newton's iteration x <- x * (2 - d * x) doubles the number of correct low bits. The initial value is correct to
+     * 5 bits for any odd `d`.
+     */
+
+    limb_t inv = (3 * d) ^ 2;
+
+    for(int i = 0; i < 4; i++) {
+        inv *= 2 - d * inv;
+    }
+
+    return inv;
+}
+
+void divexact_1(limb_t* rp, const limb_t* ap, const size_t n, const limb_t d)
+{
+    /**
+     * Hensel's division, from the least significant limb up: each quotient limb is the one that zeroes out the current
+     * limb of what remains of the dividend, and the high half of its product with `d` is borrowed from the next one.
+     */
+
+    const limb_t inv = binvert_limb(d);
+
+    limb_t borrow = 0;
+
+    for(size_t i = 0; i < n; i++) {
+        const limb_t a = ap[i];
+        const limb_t s = a - borrow;
+        const limb_t q = s * inv;
+
+        rp[i] = q;
+        borrow = mul_full(q, d).second + (a < borrow);
+    }
+}
+
+limb_t lshift(limb_t* rp, const limb_t* ap, const size_t n, const unsigned cnt)
+{
+    if(n == 0) {
+        return 0;
+    }
+
+    const unsigned tnc = LIMB_BITS - cnt;
+
+    limb_t high = ap[n - 1];
+    const limb_t out = high >> tnc;
+
+    // From the top, so that the unread source limbs never get overwritten
+    for(size_t i = n - 1; i != 0; i--) {
+        const limb_t low = ap[i - 1];
+
+        rp[i] = (high << cnt) | (low >> tnc);
+        high = low;
+    }
+
+    rp[0] = high << cnt;
+
+    return out;
+}
+
+limb_t rshift(limb_t* rp, const limb_t* ap, const size_t n, const unsigned cnt)
+{
+    if(n == 0) {
+        return 0;
+    }
+
+    const unsigned tnc = LIMB_BITS - cnt;
+
+    limb_t low = ap[0];
+    const limb_t out = low << tnc;
+
+    for(size_t i = 0; i + 1 < n; i++) {
+        const limb_t high = ap[i + 1];
+
+        rp[i] = (low >> cnt) | (high << tnc);
+        low = high;
+    }
+
+    rp[n - 1] = low >> cnt;
+
+    return out;
+}
+
+void mul_basecase(limb_t* rp, const limb_t* ap, const size_t an, const limb_t* bp, const size_t bn)
+{
+    /**
+     * Schoolbook multiplication: one row of `a` times a limb of `b` per iteration, each landing one limb higher.
+     */
+
+    rp[an] = mul_1(rp, ap, an, bp[0]);
+
+    for(size_t j = 1; j < bn; j++) {
+        rp[an + j] = addmul_1(rp + j, ap, an, bp[j]);
+    }
+}
+
+void sqr_basecase(limb_t* rp, const limb_t* ap, const size_t n)
+{
+    if(n == 1) {
+        const auto prod = mul_full(ap[0], ap[0]);
+
+        rp[0] = prod.first;
+        rp[1] = prod.second;
+
+        return;
+    }
+
+    /**
+     * Only multiply limbs i and j once, then add the doubled triangle of the cross products to the diagonal:
+     *
+     *   a^2 = 2 * sum_{i < j}(a_i * a_j * B^(i + j)) + sum_i(a_i^2 * B^(2i))
+     */
+
+    rp[0] = 0;
+    rp[n] = mul_1(rp + 1, ap + 1, n - 1, ap[0]);
+
+    for(size_t i = 1; i + 1 < n; i++) {
+        rp[n + i] = addmul_1(rp + 2 * i + 1, ap + i + 1, n - i - 1, ap[i]);
+    }
+
+    rp[2 * n - 1] = lshift(rp + 1, rp + 1, 2 * n - 2, 1);
+
+    limb_t carry = 0;
+
+    for(size_t i = 0; i < n; i++) {
+        const auto prod = mul_full(ap[i], ap[i]);
+
+        limb_t low = rp[2 * i] + prod.first;
+        limb_t c_low = low < prod.first;
+
+        low += carry;
+        c_low += low < carry;
+
+        limb_t high = rp[2 * i + 1] + prod.second;
+        limb_t c_high = high < prod.second;
+
+        high += c_low;
+        c_high += high < c_low;
+
+        rp[2 * i] = low;
+        rp[2 * i + 1] = high;
+        carry = c_high;
+    }
+}
+
+}
+}
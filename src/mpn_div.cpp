@@ -0,0 +1,435 @@
+
+#include "mpn.hpp"
+
+#include <algorithm>
+
+namespace isg {
+namespace mpn {
+
+namespace
+{
+    unsigned count_leading_zeros(const limb_t x)
+    {
+        return unsigned(__builtin_clzll(x));
+    }
+
+    /**
+     * (n1 * B + n0) / d and (n1 * B + n0) mod d, for a normalized `d` (its top bit set) and n1 < d, so that the quotient
+     * fits a limb
+     */
+    inline void udiv_2by1(limb_t& q, limb_t& r, const limb_t n1, const limb_t n0, const limb_t d)
+    {
+#if defined(__x86_64__) && defined(__GNUC__)
+        __asm__("divq %4" : "=a"(q), "=d"(r) : "a"(n0), "d"(n1), "rm"(d));
+#elif defined(__SIZEOF_INT128__)
+        const unsigned __int128 n = static_cast<unsigned __int128>(n1) << 64 | n0;
+
+        q = limb_t(n / d);
+        r = limb_t(n % d);
+#else
+        /**
+         * Knuth's algorithm D on 32-bit digits, after Hacker's Delight's `divlu`: each half of the quotient is estimated
+         * from the top digit of `d` and corrected by at most two
+         */
+        const limb_t d1 = d >> 32;
+        const limb_t d0 = d & 0xFFFFFFFF;
+
+        const limb_t n0_hi = n0 >> 32;
+        const limb_t n0_lo = n0 & 0xFFFFFFFF;
+
+        limb_t q1 = n1 / d1;
+        limb_t rhat = n1 - q1 * d1;
+
+        while(q1 >> 32 || q1 * d0 > (rhat << 32 | n0_hi)) {
+            q1 -= 1;
+            rhat += d1;
+
+            if(rhat >> 32) {
+                break;
+            }
+        }
+
+        const limb_t n21 = (n1 << 32) + n0_hi - q1 * d;
+
+        limb_t q0 = n21 / d1;
+        rhat = n21 - q0 * d1;
+
+        while(q0 >> 32 || q0 * d0 > (rhat << 32 | n0_lo)) {
+            q0 -= 1;
+            rhat += d1;
+
+            if(rhat >> 32) {
+                break;
+            }
+        }
+
+        q = q1 << 32 | q0;
+        r = (n21 << 32) + n0_lo - q0 * d;
+#endif
+    }
+
+    /**
+     * Same as `udiv_2by1`, with d's reciprocal: q is estimated as the high limb of (v + B) * n1 + n0 plus one, which is
+     * at most one too large, and the remainder, taken modulo B, tells whether it is. Being one too small is rare enough
+     * to come last.
+     */
+    inline void udiv_2by1_preinv(limb_t& q, limb_t& r, const limb_t n1, const limb_t n0, const limb_t d, const limb_t v)
+    {
+        auto qq = mul_full(v, n1);
+
+        qq.first += n0;
+        qq.second += n1 + 1 + (qq.first < n0);
+
+        q = qq.second;
+        r = n0 - q * d;
+
+        if(r > qq.first) {
+            q -= 1;
+            r += d;
+        }
+
+        if(r >= d) {
+            q += 1;
+            r -= d;
+        }
+    }
+
+    /**
+     * Both single-limb divisions, over the dividend shifted by d's normalization -- a limb at a time, so as not to
+     * write it anywhere. The quotient is only stored if `qp` isn't null.
+     */
+    limb_t divrem_1_norm(limb_t* qp, const limb_t* ap, const size_t n, const divisor_1& d)
+    {
+        if(n == 0) {
+            return 0;
+        }
+
+        const unsigned shift = d.shift;
+
+        // The bits shifted out of the top limb, below d_norm
+        limb_t r = shift != 0 ? ap[n - 1] >> (LIMB_BITS - shift) : 0;
+
+        for(size_t i = n; i-- > 0; ) {
+            limb_t u = ap[i] << shift;
+
+            if(shift != 0 && i != 0) {
+                u |= ap[i - 1] >> (LIMB_BITS - shift);
+            }
+
+            limb_t q;
+            udiv_2by1_preinv(q, r, r, u, d.d_norm, d.inv);
+
+            if(qp != nullptr) {
+                qp[i] = q;
+            }
+        }
+
+        return r >> shift;
+    }
+}
+
+limb_t invert_limb(const limb_t d)
+{
+    // (B^2 - 1 - B * d) / d, and B - 1 - d = ~d is below d
+    limb_t q, r;
+    udiv_2by1(q, r, ~d, ~limb_t(0), d);
+
+    return q;
+}
+
+divisor_1::divisor_1(const limb_t d) : d_norm(0), shift(count_leading_zeros(d)), inv(0)
+{
+    d_norm = d << shift;
+    inv = invert_limb(d_norm);
+}
+
+limb_t divrem_1(limb_t* qp, const limb_t* ap, const size_t n, const divisor_1& d)
+{
+    return divrem_1_norm(qp, ap, n, d);
+}
+
+limb_t mod_1(const limb_t* ap, const size_t n, const divisor_1& d)
+{
+    return divrem_1_norm(nullptr, ap, n, d);
+}
+
+void mod_1_many(limb_t* rs, const limb_t* ap, const size_t n, const divisor_1* ds, const size_t k)
+{
+    // As `divrem_1_norm`, with the divisors' remainders side by side, each one over the dividend under its own shift
+
+    if(n == 0) {
+        std::fill(rs, rs + k, 0);
+
+        return;
+    }
+
+    for(size_t j = 0; j < k; j++) {
+        rs[j] = ds[j].shift != 0 ? ap[n - 1] >> (LIMB_BITS - ds[j].shift) : 0;
+    }
+
+    for(size_t i = n; i-- > 0; ) {
+        const limb_t a = ap[i];
+        const limb_t a_next = i != 0 ? ap[i - 1] : 0;
+
+        for(size_t j = 0; j < k; j++) {
+            const unsigned shift = ds[j].shift;
+            const limb_t u = shift != 0 ? a << shift | a_next >> (LIMB_BITS - shift) : a;
+
+            limb_t q;
+            udiv_2by1_preinv(q, rs[j], rs[j], u, ds[j].d_norm, ds[j].inv);
+        }
+    }
+
+    for(size_t j = 0; j < k; j++) {
+        rs[j] >>= ds[j].shift;
+    }
+}
+
+namespace
+{
+    /**
+     * Knuth's algorithm D (TAOCP 4.3.1): schoolbook long division by limbs, with each quotient limb estimated from the
+     * top two limbs of the remainder and the top one of `d`. As `d` is normalized, the estimate is never more than 2 too
+     * large, and the next limb of `d` catches almost all such cases before the multiplication.
+     */
+    limb_t div_qr_schoolbook(limb_t* qp, limb_t* np, const size_t nn, const limb_t* dp, const size_t dn,
+                             const limb_t d1_inv)
+    {
+        const limb_t d1 = dp[dn - 1];
+        const limb_t d0 = dp[dn - 2];
+
+        // The top quotient limb is all there is to the top dn limbs, and can only be 0 or 1
+        limb_t* const np_top = np + (nn - dn);
+        const limb_t q_top = cmp(np_top, dp, dn) >= 0;
+
+        if(q_top) {
+            sub_n(np_top, np_top, dp, dn);
+        }
+
+        for(size_t j = nn - dn; j-- > 0; ) {
+            limb_t* const uj = np + j;
+
+            // The remainder's top limb is at most d1, since what's above `j` is below `d`
+            limb_t q_hat;
+            limb_t r_hat;
+            bool r_hat_overflows = false;
+
+            if(uj[dn] >= d1) {
+                q_hat = ~limb_t(0);
+                r_hat = uj[dn - 1] + d1;
+                r_hat_overflows = r_hat < d1;
+            }
+            else {
+                udiv_2by1_preinv(q_hat, r_hat, uj[dn], uj[dn - 1], d1, d1_inv);
+            }
+
+            // q_hat * (d1 * B + d0) > {uj + dn - 2, 3} means it's too large, which is checked while r_hat fits a limb
+            while(!r_hat_overflows) {
+                const auto q_d0 = mul_full(q_hat, d0);
+
+                if(q_d0.second < r_hat || (q_d0.second == r_hat && q_d0.first <= uj[dn - 2])) {
+                    break;
+                }
+
+                q_hat -= 1;
+                r_hat += d1;
+                r_hat_overflows = r_hat < d1;
+            }
+
+            const limb_t borrow = submul_1(uj, dp, dn, q_hat);
+
+            // Still too large by one, rarely: add `d` back
+            if(uj[dn] < borrow) {
+                q_hat -= 1;
+                uj[dn] += add_n(uj, uj, dp, dn) - borrow;
+            }
+            else {
+                uj[dn] -= borrow;
+            }
+
+            qp[j] = q_hat;
+        }
+
+        return q_top;
+    }
+
+    /**
+     * {qp, n} = {np, 2 * n} / {dp, n}, with the remainder left in {np, n} and the top quotient limb (0 or 1) returned.
+     *
+     * Burnikel and Ziegler's recursion, in GMP's arrangement: the top half of the quotient comes from dividing the top
+     * limbs of `n` by the top half of `d`, and is then corrected by subtracting its product with the bottom half, which
+     * leaves it at most 2 too large; the same again for the bottom half of the quotient. So it's two half-size
+     * divisions and two half-size products, for a division as fast as a product times log(n).
+     *
+     * Needs n limbs of scratch at `tp`.
+     */
+    limb_t div_qr_dc_n(limb_t* qp, limb_t* np, const limb_t* dp, const size_t n, const limb_t d1_inv, limb_t* tp)
+    {
+        const size_t lo = n / 2;
+        const size_t hi = n - lo;
+
+        limb_t q_hi = hi < DIV_DC_THRESHOLD
+                      ? div_qr_schoolbook(qp + lo, np + 2 * lo, 2 * hi, dp + lo, hi, d1_inv)
+                      : div_qr_dc_n(qp + lo, np + 2 * lo, dp + lo, hi, d1_inv, tp);
+
+        mul(tp, qp + lo, hi, dp, lo);
+
+        limb_t borrow = sub_n(np + lo, np + lo, tp, n);
+
+        if(q_hi != 0) {
+            borrow += sub_n(np + n, np + n, dp, lo);
+        }
+
+        while(borrow != 0) {
+            q_hi -= sub_1(qp + lo, qp + lo, hi, 1);
+            borrow -= add_n(np + lo, np + lo, dp, n);
+        }
+
+        const limb_t q_lo = lo < DIV_DC_THRESHOLD
+                            ? div_qr_schoolbook(qp, np + hi, 2 * lo, dp + hi, lo, d1_inv)
+                            : div_qr_dc_n(qp, np + hi, dp + hi, lo, d1_inv, tp);
+
+        mul(tp, dp, hi, qp, lo);
+
+        borrow = sub_n(np, np, tp, n);
+
+        if(q_lo != 0) {
+            borrow += sub_n(np + lo, np + lo, dp, hi);
+        }
+
+        while(borrow != 0) {
+            sub_1(qp, qp, lo, 1);
+            borrow -= add_n(np, np, dp, n);
+        }
+
+        return q_hi;
+    }
+}
+
+limb_t div_qr_schoolbook(limb_t* qp, limb_t* np, const size_t nn, const limb_t* dp, const size_t dn)
+{
+    return div_qr_schoolbook(qp, np, nn, dp, dn, invert_limb(dp[dn - 1]));
+}
+
+limb_t div_qr_dc(limb_t* qp, limb_t* np, const size_t nn, const limb_t* dp, const size_t dn)
+{
+    // The odd limbs at the top of the quotient go first, by the schoolbook division, then the rest a block at a time
+    const limb_t d1_inv = invert_limb(dp[dn - 1]);
+
+    const size_t qn = nn - dn;
+    const size_t q_odd = qn % dn;
+
+    const limb_t q_top = div_qr_schoolbook(qp + (qn - q_odd), np + (qn - q_odd), dn + q_odd, dp, dn, d1_inv);
+
+    scratch_frame frame;
+    limb_t* const tp = frame.alloc(dn);
+
+    // The remainder so far is below `d`, so none of the blocks has a quotient limb above it
+    for(size_t j = qn - q_odd; j != 0; ) {
+        j -= dn;
+
+        div_qr_dc_n(qp + j, np + j, dp, dn, d1_inv, tp);
+    }
+
+    return q_top;
+}
+
+void divrem(limb_t* qp, limb_t* rp, const limb_t* np, const size_t nn, const limb_t* dp, const size_t dn)
+{
+    if(dn == 1) {
+        rp[0] = divrem_1(qp, np, nn, divisor_1(dp[0]));
+
+        return;
+    }
+
+    // Both shifted so that `d`'s top bit is set, as the algorithms require
+    const unsigned shift = count_leading_zeros(dp[dn - 1]);
+
+    scratch_frame frame;
+
+    limb_t* const un = frame.alloc(nn + 1);
+    limb_t* const vn = frame.alloc(dn);
+
+    if(shift != 0) {
+        un[nn] = lshift(un, np, nn, shift);
+        lshift(vn, dp, dn, shift);
+    }
+    else {
+        un[nn] = 0;
+        std::copy(np, np + nn, un);
+        std::copy(dp, dp + dn, vn);
+    }
+
+    // The extra top limb makes for one more quotient limb than there can be, so its top one is always zero
+    if(dn < DIV_DC_THRESHOLD || nn + 1 - dn < DIV_DC_THRESHOLD) {
+        div_qr_schoolbook(qp, un, nn + 1, vn, dn);
+    }
+    else {
+        div_qr_dc(qp, un, nn + 1, vn, dn);
+    }
+
+    if(shift != 0) {
+        rshift(rp, un, dn, shift);
+    }
+    else {
+        std::copy(un, un + dn, rp);
+    }
+}
+
+void divexact(limb_t* qp, const limb_t* np, size_t nn, const limb_t* dp, size_t dn)
+{
+    // Whatever zero limbs `d` ends with, `n` ends with too
+    while(dp[0] == 0) {
+        np += 1;
+        nn -= 1;
+        dp += 1;
+        dn -= 1;
+    }
+
+    const size_t qn = nn - dn + 1;
+
+    // Only the low qn limbs of either matter, after they're shifted by d's trailing zero bits to make it odd
+    const size_t un_n = std::min(nn, qn + 1);
+    const size_t vn_n = std::min(dn, qn + 1);
+    const size_t vl = std::min(dn, qn);
+
+    const unsigned shift = unsigned(__builtin_ctzll(dp[0]));
+
+    scratch_frame frame;
+
+    limb_t* const un = frame.alloc(un_n);
+    limb_t* const vn = frame.alloc(vn_n);
+
+    if(shift != 0) {
+        rshift(un, np, un_n, shift);
+        rshift(vn, dp, vn_n, shift);
+    }
+    else {
+        std::copy(np, np + un_n, un);
+        std::copy(dp, dp + vn_n, vn);
+    }
+
+    if(dn == 1) {
+        divexact_1(qp, un, qn, vn[0]);
+
+        return;
+    }
+
+    const limb_t inv = binvert_limb(vn[0]);
+
+    for(size_t i = 0; i < qn; i++) {
+        const limb_t q = un[i] * inv;
+        qp[i] = q;
+
+        // Which zeroes the limb at `i`; the borrows beyond the low qn limbs are of no interest
+        const size_t len = std::min(vl, qn - i);
+        const limb_t borrow = submul_1(un + i, vn, len, q);
+
+        if(i + len < qn) {
+            sub_1(un + i + len, un + i + len, qn - i - len, borrow);
+        }
+    }
+}
+
+}
+}
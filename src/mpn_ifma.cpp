@@ -0,0 +1,521 @@
+
+#include "mpn.hpp"
+
+#include <algorithm>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define ISG_MPN_IFMA 1
+#endif
+
+/*
+ * Products and Montgomery products of 1024- to 4096-bit numbers with AVX-512 IFMA
+ *
+ * VPMADD52LUQ/VPMADD52HUQ add the low/high 52 bits of the 104-bit products of 52-bit lanes to 64-bit lanes, so the
+ * numbers are converted to radix 2^52 on the way in and back on the way out. The 12 spare bits of each lane take the
+ * carries: the columns are summed up without propagating them, which only happens once, at the end.
+ */
+
+namespace isg {
+namespace mpn {
+
+namespace
+{
+    constexpr unsigned DIGIT_BITS = 52;
+    constexpr limb_t DIGIT_MASK = (limb_t(1) << DIGIT_BITS) - 1;
+
+    // Digits in a vector
+    constexpr size_t LANES = 8;
+
+    // Enough digits for the largest operands, rounded up to whole vectors
+    constexpr size_t MAX_DIGITS = (IFMA_MAX_LIMBS * LIMB_BITS + DIGIT_BITS - 1) / DIGIT_BITS / LANES * LANES + LANES;
+
+    size_t digits_for(const size_t n)
+    {
+        return (n * LIMB_BITS + DIGIT_BITS - 1) / DIGIT_BITS;
+    }
+
+    size_t round_to_lanes(const size_t k)
+    {
+        return (k + LANES - 1) / LANES * LANES;
+    }
+
+    // {ds, kp} = {ap, n} in radix 2^52, zero-padded
+    void to_digits(limb_t* ds, const size_t kp, const limb_t* ap, const size_t n)
+    {
+        for(size_t d = 0; d < kp; d++) {
+            const size_t bit = d * DIGIT_BITS;
+            const size_t i = bit / LIMB_BITS;
+            const unsigned offset = bit % LIMB_BITS;
+
+            limb_t x = 0;
+
+            if(i < n) {
+                x = ap[i] >> offset;
+
+                if(offset > LIMB_BITS - DIGIT_BITS && i + 1 < n) {
+                    x |= ap[i + 1] << (LIMB_BITS - offset);
+                }
+            }
+
+            ds[d] = x & DIGIT_MASK;
+        }
+    }
+
+    // Propagates the carries through {ds, k}, leaving every digit below 2^52
+    void normalize_digits(limb_t* ds, const size_t k)
+    {
+        limb_t carry = 0;
+
+        for(size_t d = 0; d < k; d++) {
+            const limb_t x = ds[d] + carry;
+
+            ds[d] = x & DIGIT_MASK;
+            carry = x >> DIGIT_BITS;
+        }
+    }
+
+    // {rp, n} = the n limbs of normalized {ds, k} from bit `base` up
+    void from_digits(limb_t* rp, const size_t n, const limb_t* ds, const size_t k, const size_t base)
+    {
+        for(size_t i = 0; i < n; i++) {
+            const size_t bit = base + i * LIMB_BITS;
+
+            size_t d = bit / DIGIT_BITS;
+            unsigned shift = bit % DIGIT_BITS;
+
+            // A limb spans two or three digits
+            limb_t x = 0;
+
+            for(unsigned filled = 0; filled < LIMB_BITS && d < k; d++) {
+                x |= (ds[d] >> shift) << filled;
+
+                filled += DIGIT_BITS - shift;
+                shift = 0;
+            }
+
+            rp[i] = x;
+        }
+    }
+
+#ifdef ISG_MPN_IFMA
+    /**
+     * ts += x * ys * 2^(52 * offset), column-wise: the low halves of the products go to their digits, the high ones to
+     * the next digits.
+     *
+     * The accumulator is only ever accessed by whole aligned vectors, so that each load gets its value forwarded from
+     * the last store; it's the operand that gets loaded at an offset instead. For that, `ys` must have a vector of zero
+     * digits before it, and be zero-padded up to a vector past its `kp` digits.
+     */
+    __attribute__((target("avx512f,avx512ifma")))
+    inline void addmul_digit(limb_t* ts, const size_t offset, const limb_t* ys, const size_t kp, const __m512i x)
+    {
+        for(size_t j = offset / LANES * LANES; j <= offset + kp; j += LANES) {
+            const limb_t* const y_lo = ys + j - offset;
+
+            __m512i t = _mm512_load_si512(ts + j);
+
+            t = _mm512_madd52lo_epu64(t, x, _mm512_loadu_si512(y_lo));
+            t = _mm512_madd52hi_epu64(t, x, _mm512_loadu_si512(y_lo - 1));
+
+            _mm512_store_si512(ts + j, t);
+        }
+    }
+#endif
+}
+
+#ifdef ISG_MPN_IFMA
+
+__attribute__((target("avx512f,avx512ifma")))
+void mul_ifma(limb_t* rp, const limb_t* ap, const size_t an, const limb_t* bp, const size_t bn)
+{
+    const size_t ka = digits_for(an);
+    const size_t kb = digits_for(bn);
+    const size_t kbp = round_to_lanes(kb);
+
+    alignas(64) limb_t as[MAX_DIGITS];
+    alignas(64) limb_t bs[LANES + MAX_DIGITS + LANES] = { };
+    alignas(64) limb_t ts[2 * MAX_DIGITS + LANES] = { };
+
+    to_digits(as, ka, ap, an);
+    to_digits(bs + LANES, kbp, bp, bn);
+
+    // Each column takes at most 2 * kb < 2^12 additions of 52-bit values, so none of them overflows
+    for(size_t i = 0; i < ka; i++) {
+        addmul_digit(ts, i, bs + LANES, kbp, _mm512_set1_epi64(static_cast<long long>(as[i])));
+    }
+
+    normalize_digits(ts, ka + kb);
+    from_digits(rp, an + bn, ts, ka + kb, 0);
+}
+
+__attribute__((target("avx512f,avx512ifma")))
+void mont_mul_ifma(limb_t* rp, const limb_t* ap, const limb_t* bp, const limb_t* mp, const size_t n, const limb_t m_inv)
+{
+    /**
+     * Montgomery's reduction digit by digit, interleaved with the multiplication (CIOS): adding q * m zeroes out the
+     * lowest digit, which then only carries into the next one.
+     *
+     * R is B^n rather than a power of 2^52, so the last of the k digits is only reduced modulo 2^r, where r is what's
+     * left of 64 * n bits after the first k - 1 digits. The result then starts in the middle of that digit.
+     */
+
+    const size_t k = digits_for(n);
+    const size_t kp = round_to_lanes(k);
+
+    const unsigned r = unsigned(n * LIMB_BITS - (k - 1) * DIGIT_BITS);
+
+    alignas(64) limb_t as[MAX_DIGITS];
+    alignas(64) limb_t bs[LANES + MAX_DIGITS + LANES] = { };
+    alignas(64) limb_t ms[LANES + MAX_DIGITS + LANES] = { };
+    alignas(64) limb_t ts[2 * MAX_DIGITS + LANES] = { };
+
+    to_digits(as, kp, ap, n);
+    to_digits(bs + LANES, kp, bp, n);
+    to_digits(ms + LANES, kp, mp, n);
+
+    /**
+     * The carry out of the digits already reduced is kept out of the accumulator, which is only written to by vectors.
+     * Those digits are zeroes now, except for the last one's bits above r -- the result's lowest ones.
+     */
+    limb_t carry = 0;
+    limb_t t_last = 0;
+
+    for(size_t i = 0; i < k; i++) {
+        addmul_digit(ts, i, bs + LANES, kp, _mm512_set1_epi64(static_cast<long long>(as[i])));
+
+        const limb_t mask = i + 1 < k ? DIGIT_MASK : (limb_t(1) << r) - 1;
+        const limb_t q = ((ts[i] + carry) * m_inv) & mask;
+
+        addmul_digit(ts, i, ms + LANES, kp, _mm512_set1_epi64(static_cast<long long>(q)));
+
+        const limb_t t_i = ts[i] + carry;
+
+        carry = t_i >> DIGIT_BITS;
+        t_last = t_i & DIGIT_MASK;
+    }
+
+    ts[k - 1] = t_last;
+    ts[k] += carry;
+    normalize_digits(ts + k - 1, k + 2);
+
+    // a * b + q * m < 2 * m * R, so the result is n limbs and a bit
+    const size_t base = n * LIMB_BITS;
+
+    limb_t top;
+    from_digits(rp, n, ts, 2 * k + 1, base);
+    from_digits(&top, 1, ts, 2 * k + 1, base + n * LIMB_BITS);
+
+    // Same as in `redc`, without a branch
+    const limb_t borrow = sub_n(rp, rp, mp, n);
+    cnd_add_n(top ^ borrow, rp, rp, mp, n);
+}
+
+namespace
+{
+    constexpr size_t BATCH = POWER_BATCH_LANES;
+
+    // {rp, n} = {xp, n} * 2^shift mod {mp, n}, for any x
+    void mul_2exp_mod(limb_t* rp, const limb_t* xp, const size_t n, const size_t shift, const limb_t* mp)
+    {
+        const size_t mn = normalized_size(mp, n);
+        const size_t zeroes = shift / LIMB_BITS;
+        const size_t nn = zeroes + n + 1;
+
+        scratch_frame frame;
+        limb_t* const np = frame.alloc(nn);
+        limb_t* const qp = frame.alloc(nn - mn + 1);
+
+        std::fill(np, np + zeroes, 0);
+
+        if(shift % LIMB_BITS != 0) {
+            np[nn - 1] = lshift(np + zeroes, xp, n, unsigned(shift % LIMB_BITS));
+        }
+        else {
+            std::copy(xp, xp + n, np + zeroes);
+            np[nn - 1] = 0;
+        }
+
+        divrem(qp, rp, np, nn, mp, mn);
+        std::fill(rp + mn, rp + n, 0);
+    }
+
+    // Lane l's {ap, n} as the k digits of lane l in `ds`, and back
+    void lane_to_digits(limb_t* ds, const size_t k, const size_t l, const limb_t* ap, const size_t n)
+    {
+        limb_t digits[MAX_DIGITS];
+        to_digits(digits, k, ap, n);
+
+        for(size_t i = 0; i < k; i++) {
+            ds[i * BATCH + l] = digits[i];
+        }
+    }
+
+    void lane_from_digits(limb_t* rp, const size_t n, const limb_t* ds, const size_t k, const size_t l)
+    {
+        limb_t digits[MAX_DIGITS];
+
+        for(size_t i = 0; i < k; i++) {
+            digits[i] = ds[i * BATCH + l];
+        }
+
+        from_digits(rp, n, digits, k, 0);
+    }
+
+    /**
+     * {rs, k} = {as, k} * {bs, k} / 2^(52 * k) mod {ms, k} in each lane, for a, b < m < 2^(52 * k); `rs` may coincide
+     * with the operands. `ts` is scratch for 2 * k + 2 vectors.
+     *
+     * The same interleaved reduction as in `mont_mul_ifma`, only vertical: digit j of b times all of a goes into the
+     * accumulator digits j and up, then q * m with q making digit j zero, whose carry moves up a digit. The result,
+     * below 2 * m, is normalized and brought below m by a subtraction in the lanes where it doesn't borrow.
+     */
+    __attribute__((target("avx512f,avx512ifma")))
+    void mont_mul_lanes(limb_t* rs, const limb_t* as, const limb_t* bs, const limb_t* ms, const __m512i m_inv,
+                        const size_t k, __m512i* ts)
+    {
+        const __m512i zero = _mm512_setzero_si512();
+        const __m512i mask = _mm512_set1_epi64(static_cast<long long>(DIGIT_MASK));
+
+        for(size_t i = 0; i < 2 * k + 2; i++) {
+            ts[i] = zero;
+        }
+
+        for(size_t j = 0; j < k; j++) {
+            const __m512i b = _mm512_loadu_si512(bs + j * BATCH);
+            __m512i* const t = ts + j;
+
+            for(size_t i = 0; i < k; i++) {
+                const __m512i a = _mm512_loadu_si512(as + i * BATCH);
+
+                t[i] = _mm512_madd52lo_epu64(t[i], a, b);
+                t[i + 1] = _mm512_madd52hi_epu64(t[i + 1], a, b);
+            }
+
+            // Only the low 52 bits of t[0] matter for q
+            const __m512i q = _mm512_madd52lo_epu64(zero, t[0], m_inv);
+
+            for(size_t i = 0; i < k; i++) {
+                const __m512i m = _mm512_loadu_si512(ms + i * BATCH);
+
+                t[i] = _mm512_madd52lo_epu64(t[i], m, q);
+                t[i + 1] = _mm512_madd52hi_epu64(t[i + 1], m, q);
+            }
+
+            t[1] = _mm512_add_epi64(t[1], _mm512_srli_epi64(t[0], DIGIT_BITS));
+        }
+
+        // The k + 1 digits of the result, normalized, then less m with the borrow kept in the sign bit
+        __m512i* const r = ts + k;
+        __m512i* const d = ts;
+
+        __m512i carry = zero;
+        __m512i borrow = zero;
+
+        for(size_t i = 0; i <= k; i++) {
+            const __m512i x = _mm512_add_epi64(r[i], carry);
+
+            r[i] = _mm512_and_si512(x, mask);
+            carry = _mm512_srli_epi64(x, DIGIT_BITS);
+
+            const __m512i m = i < k ? _mm512_loadu_si512(ms + i * BATCH) : zero;
+            const __m512i y = _mm512_sub_epi64(_mm512_sub_epi64(r[i], m), borrow);
+
+            // The top digit of r - m only matters for the borrow, and r starts where it would go
+            if(i < k) {
+                d[i] = _mm512_and_si512(y, mask);
+            }
+
+            borrow = _mm512_srli_epi64(y, 63);
+        }
+
+        // The lanes where r - m doesn't borrow take it
+        const __mmask8 take_d = _mm512_cmpeq_epi64_mask(borrow, zero);
+
+        for(size_t i = 0; i < k; i++) {
+            _mm512_storeu_si512(rs + i * BATCH, _mm512_mask_blend_epi64(take_d, r[i], d[i]));
+        }
+    }
+
+    /**
+     * {rs, k} = the entry of the table of x^0, x^1... that each lane's bits [low, low + bits) of its exponent pick; the
+     * entries are k interleaved digits apiece, one after another
+     */
+    __attribute__((target("avx512f,avx512ifma")))
+    void gather_entries(limb_t* rs, const limb_t* table, const size_t k, const limb_t* ep, const size_t en,
+                        const size_t low, const size_t bits)
+    {
+        const size_t i = low / LIMB_BITS;
+        const unsigned shift = unsigned(low % LIMB_BITS);
+
+        alignas(64) limb_t base[BATCH];
+
+        for(size_t l = 0; l < BATCH; l++) {
+            const limb_t* const e = ep + l * en;
+
+            limb_t value = e[i] >> shift;
+
+            if(shift + bits > LIMB_BITS && i + 1 < en) {
+                value |= e[i + 1] << (LIMB_BITS - shift);
+            }
+
+            value &= (limb_t(1) << bits) - 1;
+
+            base[l] = value * k * BATCH + l;
+        }
+
+        const __m512i index = _mm512_load_si512(base);
+
+        for(size_t j = 0; j < k; j++) {
+            const __m512i digit_index = _mm512_add_epi64(index, _mm512_set1_epi64(static_cast<long long>(j * BATCH)));
+
+            _mm512_storeu_si512(rs + j * BATCH, _mm512_i64gather_epi64(digit_index, table, 8));
+        }
+    }
+}
+
+__attribute__((target("avx512f,avx512ifma")))
+void power_batch_ifma(limb_t* rp, const limb_t* xp, const limb_t* ep, const size_t en, const limb_t* mp, const size_t n)
+{
+    /**
+     * R = 2^(52 * k) here, the radix the lanes work in, rather than B^n; the results are the same. The windows are
+     * fixed, so that every lane can take the same steps: the table of x^0...x^(2^window - 1) of each lane is looked up
+     * by the lane's own index.
+     */
+
+    const size_t k = digits_for(n);
+    const size_t r_bits = k * DIGIT_BITS;
+
+    const size_t n_bits = en * LIMB_BITS;
+    // Narrower than a single power's at the top: the table holds eight lanes' powers, some 160 KB at 4096 bits with
+    // 5-bit windows, which a sixth bit would double to save a couple percent of the products
+    const size_t window = std::min(power_window_bits(n_bits), size_t(5));
+    const size_t n_entries = size_t(1) << window;
+
+    scratch_frame frame;
+
+    limb_t* const ms = frame.alloc(k * BATCH);
+    limb_t* const table = frame.alloc(n_entries * k * BATCH);
+    limb_t* const r = frame.alloc(k * BATCH);
+    limb_t* const t = frame.alloc(k * BATCH);
+    limb_t* const xm = frame.alloc(n);
+
+    __m512i ts[2 * MAX_DIGITS + 2];
+
+    alignas(64) limb_t m_invs[BATCH];
+
+    for(size_t l = 0; l < BATCH; l++) {
+        const limb_t* const m = mp + l * n;
+
+        lane_to_digits(ms, k, l, m, n);
+        m_invs[l] = (0 - binvert_limb(m[0])) & DIGIT_MASK;
+
+        // x^0 = R mod m and x^1 = x * R mod m
+        std::fill(xm, xm + n, 0);
+        xm[0] = 1;
+
+        mul_2exp_mod(xm, xm, n, r_bits, m);
+        lane_to_digits(table, k, l, xm, n);
+
+        mul_2exp_mod(xm, xp + l * n, n, r_bits, m);
+        lane_to_digits(table + k * BATCH, k, l, xm, n);
+    }
+
+    const __m512i m_inv = _mm512_load_si512(m_invs);
+
+    for(size_t e = 2; e < n_entries; e++) {
+        mont_mul_lanes(table + e * k * BATCH, table + (e - 1) * k * BATCH, table + k * BATCH, ms, m_inv, k, ts);
+    }
+
+    const size_t top = n_bits % window != 0 ? n_bits % window : window;
+    size_t low = n_bits - top;
+
+    gather_entries(r, table, k, ep, en, low, top);
+
+    while(low != 0) {
+        low -= window;
+
+        for(size_t j = 0; j < window; j++) {
+            mont_mul_lanes(r, r, r, ms, m_inv, k, ts);
+        }
+
+        gather_entries(t, table, k, ep, en, low, window);
+        mont_mul_lanes(r, r, t, ms, m_inv, k, ts);
+    }
+
+    // Out of the form by a product with 1
+    std::fill(t, t + k * BATCH, 0);
+    std::fill(t, t + BATCH, 1);
+
+    mont_mul_lanes(r, r, t, ms, m_inv, k, ts);
+
+    for(size_t l = 0; l < BATCH; l++) {
+        lane_from_digits(rp + l * n, n, r, k, l);
+    }
+}
+
+#else
+
+// Never selected without IFMA, these are only here for the linker
+
+void mul_ifma(limb_t* rp, const limb_t* ap, const size_t an, const limb_t* bp, const size_t bn)
+{
+    mul_basecase(rp, ap, an, bp, bn);
+}
+
+void mont_mul_ifma(limb_t* rp, const limb_t* ap, const limb_t* bp, const limb_t* mp, const size_t n, const limb_t m_inv)
+{
+    limb_t tp[2 * IFMA_MAX_LIMBS];
+
+    mont_mul_basecase(rp, ap, bp, mp, n, m_inv, tp);
+}
+
+void power_batch_ifma(limb_t* rp, const limb_t* xp, const limb_t* ep, const size_t en, const limb_t* mp, const size_t n)
+{
+    // Lane by lane, bit by bit, with R = B^n
+    scratch_frame frame;
+
+    limb_t* const x = frame.alloc(n);
+    limb_t* const np = frame.alloc(2 * n + 1);
+    // The quotients of the 2 * n + 1 limbs by m, which may be shorter than n limbs
+    limb_t* const qp = frame.alloc(2 * n + 2);
+    limb_t* const tp = frame.alloc(2 * n);
+
+    for(size_t l = 0; l < POWER_BATCH_LANES; l++) {
+        const limb_t* const m = mp + l * n;
+        const size_t mn = normalized_size(m, n);
+
+        const limb_t m_inv = 0 - binvert_limb(m[0]);
+
+        limb_t* const r = rp + l * n;
+
+        // x * R mod m, and R mod m for the result
+        std::fill(np, np + 2 * n + 1, 0);
+        std::copy(xp + l * n, xp + (l + 1) * n, np + n);
+        divrem(qp, x, np, 2 * n + 1, m, mn);
+
+        std::fill(np, np + 2 * n + 1, 0);
+        np[n] = 1;
+        divrem(qp, r, np, 2 * n + 1, m, mn);
+
+        std::fill(x + mn, x + n, 0);
+        std::fill(r + mn, r + n, 0);
+
+        for(size_t i = en * LIMB_BITS; i-- > 0; ) {
+            mont_mul_basecase(r, r, r, m, n, m_inv, tp);
+
+            if((ep[l * en + i / LIMB_BITS] >> (i % LIMB_BITS) & 1) != 0) {
+                mont_mul_basecase(r, r, x, m, n, m_inv, tp);
+            }
+        }
+
+        std::fill(tp, tp + 2 * n, 0);
+        std::copy(r, r + n, tp);
+        redc(r, tp, m, n, m_inv);
+    }
+}
+
+#endif
+
+}
+}
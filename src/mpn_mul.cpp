@@ -0,0 +1,675 @@
+
+#include "mpn.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+/*
+ * The multiplication ladder: the dispatcher and the subquadratic algorithms it picks from
+ */
+
+namespace isg {
+namespace mpn {
+
+namespace
+{
+    /**
+     * {rp, an} = |{ap, an} - {bp, bn}|, an >= bn
+     *
+     * @return Whether the difference is negative
+     */
+    bool sub_abs(limb_t* rp, const limb_t* ap, const size_t an, const limb_t* bp, const size_t bn)
+    {
+        bool a_less = false;
+
+        // `a`'s extra limbs decide the comparison unless they're all zero
+        if(normalized_size(ap + bn, an - bn) == 0) {
+            a_less = cmp(ap, bp, bn) < 0;
+        }
+
+        if(a_less) {
+            // Only the low `bn` limbs of `a` can be non-zero here
+            sub_n(rp, bp, ap, bn);
+            std::fill(rp + bn, rp + an, 0);
+        }
+        else {
+            sub(rp, ap, an, bp, bn);
+        }
+
+        return a_less;
+    }
+
+    /*
+     * Two's complement arithmetic on fixed-size buffers, for Toom-Cook's interpolation: its intermediate values can be
+     * negative, but they're all integers far below the buffers' range.
+     */
+
+    bool is_neg(const limb_t* ap, const size_t n)
+    {
+        return (ap[n - 1] >> (LIMB_BITS - 1)) != 0;
+    }
+
+    // {rp, n} = -{ap, n}
+    void neg_n(limb_t* rp, const limb_t* ap, const size_t n)
+    {
+        size_t i = 0;
+
+        for(; i < n && ap[i] == 0; i++) {
+            rp[i] = 0;
+        }
+
+        if(i < n) {
+            rp[i] = -ap[i];
+
+            for(i++; i < n; i++) {
+                rp[i] = ~ap[i];
+            }
+        }
+    }
+
+    // {rp, n} *= x
+    void mul_small(limb_t* rp, const size_t n, const int64_t x)
+    {
+        mul_1(rp, rp, n, limb_t(x < 0 ? -x : x));
+
+        if(x < 0) {
+            neg_n(rp, rp, n);
+        }
+    }
+
+    // {rp, n} /= x, where x divides {rp, n}
+    void divexact_small(limb_t* rp, const size_t n, const int64_t x)
+    {
+        limb_t d = limb_t(x < 0 ? -x : x);
+        unsigned n_twos = 0;
+
+        for(; (d & 1) == 0; d >>= 1) {
+            n_twos += 1;
+        }
+
+        if(n_twos != 0) {
+            // Arithmetic shift: fill the vacated bits with the sign
+            const bool neg = is_neg(rp, n);
+
+            rshift(rp, rp, n, n_twos);
+
+            if(neg) {
+                rp[n - 1] |= ~limb_t(0) << (LIMB_BITS - n_twos);
+            }
+        }
+
+        if(d != 1) {
+            divexact_1(rp, rp, n, d);
+        }
+
+        if(x < 0) {
+            neg_n(rp, rp, n);
+        }
+    }
+
+    /**
+     * {rp, n + 1} = |p(x)|, where p(x) = sum(p_i * x^i) with p_i being the `k` `n`-limb pieces of {ap, an}
+     *
+     * Needs n + 1 limbs of scratch at `tp`; supports |x|^(k - 1) * 2 < 2^64.
+     *
+     * @return Whether p(x) < 0
+     */
+    bool toom_evaluate(limb_t* rp, const limb_t* ap, const size_t an, const size_t k, const size_t n,
+                       const int64_t x, limb_t* tp)
+    {
+        // The even and the odd powers' terms are summed separately, so that p(-x) is just their difference
+        limb_t* const sum_even = rp;
+        limb_t* const sum_odd = tp;
+
+        std::fill(sum_even, sum_even + n + 1, 0);
+        std::fill(sum_odd, sum_odd + n + 1, 0);
+
+        const limb_t abs_x = limb_t(x < 0 ? -x : x);
+        limb_t x_pow = 1;
+
+        for(size_t i = 0; i < k && x_pow != 0; i++, x_pow *= abs_x) {
+            const size_t len = i + 1 < k ? n : an - (k - 1) * n;
+
+            limb_t* const acc = i % 2 == 0 ? sum_even : sum_odd;
+
+            const limb_t carry = addmul_1(acc, ap + i * n, len, x_pow);
+            add_1(acc + len, acc + len, n + 1 - len, carry);
+        }
+
+        if(x >= 0) {
+            add_n(rp, sum_even, sum_odd, n + 1);
+
+            return false;
+        }
+        else {
+            return sub_abs(rp, sum_even, n + 1, sum_odd, n + 1);
+        }
+    }
+
+    /**
+     * Toom-Cook multiplication of `a`, split into `ka` pieces, by `b`, split into `kb` pieces.
+     *
+     * The pieces are the coefficients of polynomials a(x) and b(x), so that a = a(B^n) and b = b(B^n). Their product
+     * c(x) of degree d = ka + kb - 2 is found from its values at d + 1 points, each of which only takes one product of
+     * (n + 1)-limb numbers: at 0, 1, -1, 2, -2, ... and the "infinity" (the product of the leading coefficients).
+     *
+     * The interpolation is done the generic way, through Newton's divided differences, which are integers for integer
+     * points and a polynomial with integer coefficients. It's not the shortest sequence of operations there is for
+     * any given k, but these are linear in n anyway.
+     *
+     * Squares when `a` and `b` are the same number split the same way: then the evaluations are too.
+     */
+    void mul_toom(limb_t* rp, const limb_t* ap, const size_t an, const limb_t* bp, const size_t bn,
+                  const size_t ka, const size_t kb)
+    {
+        const size_t n = std::max((an + ka - 1) / ka, (bn + kb - 1) / kb);
+        const size_t s = an - (ka - 1) * n;
+        const size_t t = bn - (kb - 1) * n;
+
+        const size_t deg = ka + kb - 2;
+
+        const bool squaring = ap == bp && an == bn && ka == kb;
+
+        // Room for a product of two evaluations, plus the sign
+        const size_t len = 2 * n + 2;
+
+        // The evaluations take 4 * (n + 1) limbs each, which are only reused when the products are run in sequence
+        const bool threads = use_threads(bn);
+        const size_t eval_size = 4 * (n + 1);
+
+        scratch_frame frame;
+
+        limb_t* const evals = frame.alloc((threads ? deg : 1) * eval_size + 2 * deg * len);
+        limb_t* const ws = evals + (threads ? deg : 1) * eval_size;
+        limb_t* const cs = ws + deg * len;
+
+        const auto point = [](size_t j) -> int64_t {
+            const auto m = int64_t((j + 1) / 2);
+
+            return j % 2 == 1 ? m : -m;
+        };
+
+        // c_d = a_(ka - 1) * b_(kb - 1) -- the value at the infinity -- lands right where it belongs
+        limb_t* const c_top = rp + deg * n;
+
+        const auto product_top = [=] {
+            if(squaring) {
+                sqr(c_top, ap + (ka - 1) * n, s);
+            }
+            else {
+                mul(c_top, ap + (ka - 1) * n, s, bp + (kb - 1) * n, t);
+            }
+        };
+
+        // w_j = c(x_j)
+        const auto product_at = [=](const size_t j) {
+            limb_t* const ea = evals + (threads ? j : 0) * eval_size;
+            limb_t* const eb = ea + (n + 1);
+            limb_t* const tp = eb + (n + 1);
+
+            const int64_t x = point(j);
+            limb_t* const w = ws + j * len;
+
+            const bool neg_a = toom_evaluate(ea, ap, an, ka, n, x, tp);
+            const bool neg_b = squaring ? neg_a : toom_evaluate(eb, bp, bn, kb, n, x, tp);
+
+            const size_t ean = normalized_size(ea, n + 1);
+            const size_t ebn = squaring ? ean : normalized_size(eb, n + 1);
+
+            std::fill(w, w + len, 0);
+
+            if(squaring && ean != 0) {
+                sqr(w, ea, ean);
+            }
+            else if(ean != 0 && ebn != 0) {
+                mul(w, ea, ean, eb, ebn);
+            }
+
+            if(neg_a != neg_b) {
+                neg_n(w, w, len);
+            }
+        };
+
+        if(threads) {
+            std::vector<std::function<void()>> products(1, product_top);
+
+            for(size_t j = 0; j < deg; j++) {
+                products.emplace_back(std::bind(product_at, j));
+            }
+
+            run_parallel(products);
+        }
+        else {
+            product_top();
+
+            for(size_t j = 0; j < deg; j++) {
+                product_at(j);
+            }
+        }
+
+        for(size_t j = 0; j < deg; j++) {
+            const int64_t x = point(j);
+            limb_t* const w = ws + j * len;
+
+            // Take the leading term out: c(x) - c_d * x^d is a polynomial of degree d - 1
+            int64_t x_pow = 1;
+
+            for(size_t i = 0; i < deg; i++) {
+                x_pow *= x;
+            }
+
+            if(x_pow > 0) {
+                const limb_t borrow = submul_1(w, c_top, s + t, limb_t(x_pow));
+                sub_1(w + s + t, w + s + t, len - (s + t), borrow);
+            }
+            else if(x_pow < 0) {
+                const limb_t carry = addmul_1(w, c_top, s + t, limb_t(-x_pow));
+                add_1(w + s + t, w + s + t, len - (s + t), carry);
+            }
+        }
+
+        // w_j = c[x_0, ..., x_j], each round k turning c[x_(j - k + 1), ..., x_j] into c[x_(j - k), ..., x_j]
+        for(size_t k = 1; k < deg; k++) {
+            for(size_t j = deg - 1; j >= k; j--) {
+                limb_t* const w = ws + j * len;
+
+                sub_n(w, w, w - len, len);
+                divexact_small(w, len, point(j) - point(j - k));
+            }
+        }
+
+        /**
+         * From Newton's form to the coefficients, Horner-style:
+         *
+         *   c(x) = w_0 + (x - x_0) * (w_1 + (x - x_1) * (w_2 + ...))
+         */
+        std::copy(ws + (deg - 1) * len, ws + deg * len, cs);
+
+        for(size_t j = deg - 1, i_top = 0; j-- > 0; i_top++) {
+            const int64_t x = point(j);
+
+            // (c_0 + c_1 * x + ...) * (x - x_j): each coefficient becomes the lower one minus itself times x_j
+            std::copy(cs + i_top * len, cs + (i_top + 1) * len, cs + (i_top + 1) * len);
+
+            for(size_t i = i_top + 1; i-- > 0;) {
+                limb_t* const c = cs + i * len;
+
+                if(x != 0) {
+                    mul_small(c, len, x);
+                }
+                else {
+                    std::fill(c, c + len, 0);
+                }
+
+                if(i != 0) {
+                    sub_n(c, c - len, c, len);
+                }
+                else {
+                    sub_n(c, ws + j * len, c, len);
+                }
+            }
+        }
+
+        // Add up the overlapping coefficients, leaving the top one where it is
+        std::fill(rp, c_top, 0);
+
+        for(size_t i = 0; i < deg; i++) {
+            const size_t rn = an + bn - i * n;
+            const size_t cn = std::min(normalized_size(cs + i * len, len), rn);
+
+            add(rp + i * n, rp + i * n, rn, cs + i * len, cn);
+        }
+    }
+
+    /**
+     * {rp, an + bn} = {ap, an} * {bp, bn} for bn <= ceil(an / 2), by slicing `a` into `bn`-limb chunks
+     */
+    void mul_unbalanced(limb_t* rp, const limb_t* ap, const size_t an, const limb_t* bp, const size_t bn)
+    {
+        mul(rp, ap, bn, bp, bn);
+
+        scratch_frame frame;
+        limb_t* const prod = frame.alloc(2 * bn);
+
+        for(size_t offset = bn; offset < an; offset += bn) {
+            const size_t len = std::min(bn, an - offset);
+
+            mul(prod, ap + offset, len, bp, bn);
+
+            // The low half overlaps what's already there, the rest lands on fresh limbs
+            const limb_t carry = add_n(rp + offset, rp + offset, prod, bn);
+            add_1(rp + offset + bn, prod + bn, len, carry);
+        }
+    }
+}
+
+void mul_karatsuba(limb_t* rp, const limb_t* ap, const size_t an, const limb_t* bp, const size_t bn)
+{
+    /**
+     * a = a1 * B^n + a0, b = b1 * B^n + b0, with
+     *
+     *   a * b = a1 * b1 * B^2n + (a0 * b1 + a1 * b0) * B^n + a0 * b0,
+     *   a0 * b1 + a1 * b0 = a0 * b0 + a1 * b1 - (a0 - a1) * (b0 - b1)
+     *
+     * So it's three half-size products instead of four. The subtractive form keeps the middle factors at `n` limbs.
+     */
+
+    const size_t n = (an + 1) / 2;
+    const size_t s = an - n;
+    const size_t t = bn - n;
+
+    const limb_t* a0 = ap;
+    const limb_t* a1 = ap + n;
+    const limb_t* b0 = bp;
+    const limb_t* b1 = bp + n;
+
+    scratch_frame frame;
+
+    limb_t* const da = frame.alloc(6 * n + 1);
+    limb_t* const db = da + n;
+    limb_t* const zm = db + n;
+    limb_t* const mid = zm + 2 * n;
+
+    // (a0 - a1) * (b0 - b1) is negative when exactly one of the differences is
+    const bool neg_m = sub_abs(da, a0, n, a1, s) != sub_abs(db, b0, n, b1, t);
+
+    // z0 and z2 go straight to where they belong in the product
+    const auto z0 = [=] { mul(rp, a0, n, b0, n); };
+    const auto z2 = [=] { mul(rp + 2 * n, a1, s, b1, t); };
+    const auto z1 = [=] { mul(zm, da, n, db, n); };
+
+    if(use_threads(bn)) {
+        run_parallel({ z0, z2, z1 });
+    }
+    else {
+        z0();
+        z2();
+        z1();
+    }
+
+    // mid = z0 + z2 -+ zm
+    mid[2 * n] = add(mid, rp, 2 * n, rp + 2 * n, s + t);
+
+    if(neg_m) {
+        add(mid, mid, 2 * n + 1, zm, 2 * n);
+    }
+    else {
+        sub(mid, mid, 2 * n + 1, zm, 2 * n);
+    }
+
+    // The middle term is below B^(s + n + 1), so its limbs past the product's end (if any) are zeroes
+    const size_t mid_size = std::min(2 * n + 1, an + bn - n);
+    add(rp + n, rp + n, an + bn - n, mid, mid_size);
+}
+
+void sqr_karatsuba(limb_t* rp, const limb_t* ap, const size_t n)
+{
+    /**
+     * Same as multiplication, only the middle term is a0^2 + a1^2 - (a0 - a1)^2, with the last square never negative
+     */
+
+    const size_t h = (n + 1) / 2;
+    const size_t s = n - h;
+
+    const limb_t* a0 = ap;
+    const limb_t* a1 = ap + h;
+
+    scratch_frame frame;
+
+    limb_t* const da = frame.alloc(5 * h + 1);
+    limb_t* const zm = da + h;
+    limb_t* const mid = zm + 2 * h;
+
+    sub_abs(da, a0, h, a1, s);
+
+    const auto z0 = [=] { sqr(rp, a0, h); };
+    const auto z2 = [=] { sqr(rp + 2 * h, a1, s); };
+    const auto z1 = [=] { sqr(zm, da, h); };
+
+    if(use_threads(n)) {
+        run_parallel({ z0, z2, z1 });
+    }
+    else {
+        z0();
+        z2();
+        z1();
+    }
+
+    mid[2 * h] = add(mid, rp, 2 * h, rp + 2 * h, 2 * s);
+    sub(mid, mid, 2 * h + 1, zm, 2 * h);
+
+    const size_t mid_size = std::min(2 * h + 1, 2 * n - h);
+    add(rp + h, rp + h, 2 * n - h, mid, mid_size);
+}
+
+void mul_toom33(limb_t* rp, const limb_t* ap, const size_t an, const limb_t* bp, const size_t bn)
+{
+    mul_toom(rp, ap, an, bp, bn, 3, 3);
+}
+
+void mul_toom44(limb_t* rp, const limb_t* ap, const size_t an, const limb_t* bp, const size_t bn)
+{
+    mul_toom(rp, ap, an, bp, bn, 4, 4);
+}
+
+void mul_toom32(limb_t* rp, const limb_t* ap, const size_t an, const limb_t* bp, const size_t bn)
+{
+    mul_toom(rp, ap, an, bp, bn, 3, 2);
+}
+
+void mul_toom42(limb_t* rp, const limb_t* ap, const size_t an, const limb_t* bp, const size_t bn)
+{
+    mul_toom(rp, ap, an, bp, bn, 4, 2);
+}
+
+void sqr_toom3(limb_t* rp, const limb_t* ap, const size_t n)
+{
+    mul_toom(rp, ap, n, ap, n, 3, 3);
+}
+
+void sqr_toom4(limb_t* rp, const limb_t* ap, const size_t n)
+{
+    mul_toom(rp, ap, n, ap, n, 4, 4);
+}
+
+namespace
+{
+    // Whether the operands split into `ka` and `kb` pieces leave each with a non-empty top one
+    bool toom_fits(const size_t an, const size_t bn, const size_t ka, const size_t kb)
+    {
+        const size_t n = std::max((an + ka - 1) / ka, (bn + kb - 1) / kb);
+
+        return an > (ka - 1) * n && bn > (kb - 1) * n;
+    }
+
+    thread_local size_t n_subquadratic = 0;
+
+    // The rest of `mul`'s ladder, for an >= bn >= MUL_KARATSUBA_THRESHOLD
+    void mul_subquadratic(limb_t* rp, const limb_t* ap, const size_t an, const limb_t* bp, const size_t bn)
+    {
+        n_subquadratic++;
+
+        if(bn >= MUL_NTT_THRESHOLD) {
+            mul_ntt(rp, ap, an, bp, bn);
+        }
+        else if(4 * an < 5 * bn) {
+            // Balanced enough for splitting both operands the same way
+            if(bn >= MUL_TOOM44_THRESHOLD && toom_fits(an, bn, 4, 4)) {
+                mul_toom44(rp, ap, an, bp, bn);
+            }
+            else if(bn >= MUL_TOOM33_THRESHOLD && toom_fits(an, bn, 3, 3)) {
+                mul_toom33(rp, ap, an, bp, bn);
+            }
+            else {
+                mul_karatsuba(rp, ap, an, bp, bn);
+            }
+        }
+        else if(4 * an < 7 * bn) {
+            // Around 3:2
+            if(bn >= MUL_TOOM32_THRESHOLD && toom_fits(an, bn, 3, 2)) {
+                mul_toom32(rp, ap, an, bp, bn);
+            }
+            else {
+                mul_karatsuba(rp, ap, an, bp, bn);
+            }
+        }
+        else if(4 * an < 11 * bn && bn >= MUL_TOOM42_THRESHOLD && toom_fits(an, bn, 4, 2)) {
+            // Around 2:1
+            mul_toom42(rp, ap, an, bp, bn);
+        }
+        else if(2 * bn > an + 1) {
+            mul_karatsuba(rp, ap, an, bp, bn);
+        }
+        else {
+            // Too short a `b` to split it at the same point as `a`
+            mul_unbalanced(rp, ap, an, bp, bn);
+        }
+    }
+
+    // Same for `sqr`, for n >= SQR_KARATSUBA_THRESHOLD
+    void sqr_subquadratic(limb_t* rp, const limb_t* ap, const size_t n)
+    {
+        n_subquadratic++;
+
+        if(n >= SQR_NTT_THRESHOLD) {
+            sqr_ntt(rp, ap, n);
+        }
+        else if(n >= SQR_TOOM4_THRESHOLD && toom_fits(n, n, 4, 4)) {
+            sqr_toom4(rp, ap, n);
+        }
+        else if(n >= SQR_TOOM3_THRESHOLD && toom_fits(n, n, 3, 3)) {
+            sqr_toom3(rp, ap, n);
+        }
+        else {
+            sqr_karatsuba(rp, ap, n);
+        }
+    }
+}
+
+void mul(limb_t* rp, const limb_t* ap, const size_t an, const limb_t* bp, const size_t bn)
+{
+    if(an < bn) {
+        mul(rp, bp, bn, ap, an);
+    }
+    else if(ap == bp && an == bn) {
+        sqr(rp, ap, an);
+    }
+    else if(bn >= MUL_IFMA_THRESHOLD && an <= IFMA_MAX_LIMBS && current_kernels() == kernels::avx512_ifma) {
+        mul_ifma(rp, ap, an, bp, bn);
+    }
+    else if(bn < MUL_KARATSUBA_THRESHOLD) {
+        mul_basecase(rp, ap, an, bp, bn);
+    }
+    else {
+        mul_subquadratic(rp, ap, an, bp, bn);
+    }
+}
+
+void sqr(limb_t* rp, const limb_t* ap, const size_t n)
+{
+    if(n < SQR_KARATSUBA_THRESHOLD) {
+        sqr_basecase(rp, ap, n);
+    }
+    else {
+        sqr_subquadratic(rp, ap, n);
+    }
+}
+
+size_t subquadratic_calls()
+{
+    return n_subquadratic;
+}
+
+void redc(limb_t* rp, limb_t* tp, const limb_t* mp, const size_t n, const limb_t m_inv)
+{
+    /**
+     * Adding q * m with q = -t * m^-1 mod B zeroes out the lowest limb of t, one limb at a time. What's left after n
+     * of them is (t + Q * m) / B^n < 2 * m.
+     *
+     * The carry out of each row goes where its zero limb was, and all of them are added at once in the end, rather
+     * than rippling up through as many limbs as it takes.
+     */
+
+    for(size_t i = 0; i < n; i++) {
+        tp[i] = addmul_1(tp + i, mp, n, tp[i] * m_inv);
+    }
+
+    const limb_t top = add_n(rp, tp + n, tp, n);
+
+    /**
+     * Subtracting m always and adding it back unless that was right, so as not to branch on the data. With top = 1,
+     * the difference is below m and borrows, so the subtraction was right exactly when it borrowed as much as `top`.
+     */
+    const limb_t borrow = sub_n(rp, rp, mp, n);
+    cnd_add_n(top ^ borrow, rp, rp, mp, n);
+}
+
+void mont_mul_basecase(limb_t* rp, const limb_t* ap, const limb_t* bp, const limb_t* mp, const size_t n,
+                       const limb_t m_inv, limb_t* tp)
+{
+    mul_basecase(tp, ap, n, bp, n);
+    redc(rp, tp, mp, n, m_inv);
+}
+
+void mont_sqr_basecase(limb_t* rp, const limb_t* ap, const limb_t* mp, const size_t n, const limb_t m_inv, limb_t* tp)
+{
+    sqr_basecase(tp, ap, n);
+    redc(rp, tp, mp, n, m_inv);
+}
+
+namespace
+{
+    bool use_mont_ifma(const size_t n)
+    {
+        return n >= IFMA_MIN_LIMBS && n <= IFMA_MAX_LIMBS && current_kernels() == kernels::avx512_ifma;
+    }
+}
+
+void mont_mul(limb_t* rp, const limb_t* ap, const limb_t* bp, const limb_t* mp, const size_t n, const limb_t m_inv,
+              limb_t* tp)
+{
+    if(use_mont_ifma(n)) {
+        mont_mul_ifma(rp, ap, bp, mp, n, m_inv);
+    }
+    else {
+        mul(tp, ap, n, bp, n);
+        redc(rp, tp, mp, n, m_inv);
+    }
+}
+
+void mont_sqr(limb_t* rp, const limb_t* ap, const limb_t* mp, const size_t n, const limb_t m_inv, limb_t* tp)
+{
+    // The IFMA one reduces as it multiplies, which leaves no room for squaring's savings
+    if(use_mont_ifma(n)) {
+        mont_mul_ifma(rp, ap, ap, mp, n, m_inv);
+    }
+    else {
+        sqr(tp, ap, n);
+        redc(rp, tp, mp, n, m_inv);
+    }
+}
+
+void mont_mul_sec(limb_t* rp, const limb_t* ap, const limb_t* bp, const limb_t* mp, const size_t n,
+                  const limb_t m_inv, limb_t* tp)
+{
+    if(use_mont_ifma(n)) {
+        mont_mul_ifma(rp, ap, bp, mp, n, m_inv);
+    }
+    else {
+        mont_mul_basecase(rp, ap, bp, mp, n, m_inv, tp);
+    }
+}
+
+void mont_sqr_sec(limb_t* rp, const limb_t* ap, const limb_t* mp, const size_t n, const limb_t m_inv, limb_t* tp)
+{
+    if(use_mont_ifma(n)) {
+        mont_mul_ifma(rp, ap, ap, mp, n, m_inv);
+    }
+    else {
+        mont_sqr_basecase(rp, ap, mp, n, m_inv, tp);
+    }
+}
+
+}
+}
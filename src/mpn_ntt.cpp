@@ -0,0 +1,369 @@
+
+#include "mpn.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+/*
+ * Multiplication through the number-theoretic transform
+ *
+ * The limbs themselves are the coefficients to convolve. A coefficient of the convolution of two N-limb numbers is
+ * below N * 2^128, so it's computed modulo three primes just above 2^60 and recovered from the residues by the CRT.
+ * Each prime is c * 2^k + 1 with k >= 55, so it has roots of unity of all the orders up to 2^55, which is the limit
+ * on the product's size.
+ */
+
+namespace isg {
+namespace mpn {
+
+namespace
+{
+    /**
+     * Arithmetic modulo a prime p < 2^62, with the multiplication in Montgomery's form (R = 2^64)
+     */
+    struct ntt_prime
+    {
+        limb_t p;
+        // -p^-1 mod R
+        limb_t p_neg_inv;
+        // R^2 mod p
+        limb_t r2;
+        // A generator of the multiplicative group
+        limb_t g;
+
+        ntt_prime(const limb_t p, const limb_t g) : p(p), p_neg_inv(-binvert_limb(p)), r2(0), g(g)
+        {
+            // R mod p, then doubled 64 more times
+            limb_t r = (UINT64_MAX % p + 1) % p;
+
+            for(unsigned i = 0; i < LIMB_BITS; i++) {
+                r = add(r, r);
+            }
+
+            r2 = r;
+        }
+
+        limb_t add(limb_t a, limb_t b) const
+        {
+            a += b;
+
+            return a >= p ? a - p : a;
+        }
+
+        limb_t sub(const limb_t a, const limb_t b) const
+        {
+            return a >= b ? a - b : a + p - b;
+        }
+
+        // a * b * R^-1 mod p
+        limb_t mont_mul(const limb_t a, const limb_t b) const
+        {
+            const auto ab = mul_full(a, b);
+            const auto mp = mul_full(ab.first * p_neg_inv, p);
+
+            // The low halves add up to zero mod R, so there's a carry unless both are zero
+            limb_t t = ab.second + mp.second + (ab.first != 0);
+
+            return t >= p ? t - p : t;
+        }
+
+        limb_t to_mont(const limb_t a) const
+        {
+            return mont_mul(a, r2);
+        }
+
+        limb_t from_mont(const limb_t a) const
+        {
+            return mont_mul(a, 1);
+        }
+
+        // x^e, all in Montgomery form
+        limb_t mont_pow(limb_t x, limb_t e) const
+        {
+            limb_t result = to_mont(1);
+
+            for(; e; e >>= 1) {
+                if(e & 1) {
+                    result = mont_mul(result, x);
+                }
+
+                x = mont_mul(x, x);
+            }
+
+            return result;
+        }
+
+        // A primitive n-th root of unity (or its inverse), in Montgomery form
+        limb_t mont_root(const size_t n, const bool inverse) const
+        {
+            const limb_t w = mont_pow(to_mont(g), (p - 1) / n);
+
+            return inverse ? mont_pow(w, p - 2) : w;
+        }
+    };
+
+    const ntt_prime& prime(const size_t i)
+    {
+        static const ntt_prime primes[3] = {
+                { 4179340454199820289ULL, 3 },  // 29 * 2^57 + 1
+                { 2485986994308513793ULL, 5 },  // 69 * 2^55 + 1
+                { 1945555039024054273ULL, 5 }   // 27 * 2^56 + 1
+        };
+
+        return primes[i];
+    }
+
+    /**
+     * Twiddle factors for every level of an n-point transform: the ones of the level with butterflies spanning `len`
+     * are at [len, 2 * len), so that each level's are contiguous.
+     */
+    void ntt_twiddles(limb_t* tw, const ntt_prime& q, const size_t n, const bool inverse)
+    {
+        if(n < 2) {
+            return;
+        }
+
+        const limb_t w = q.mont_root(n, inverse);
+
+        tw[n / 2] = q.to_mont(1);
+
+        for(size_t j = n / 2 + 1; j < n; j++) {
+            tw[j] = q.mont_mul(tw[j - 1], w);
+        }
+
+        for(size_t len = n / 4; len != 0; len /= 2) {
+            for(size_t j = 0; j < len; j++) {
+                tw[len + j] = tw[2 * (len + j)];
+            }
+        }
+    }
+
+    // Decimation in frequency: natural order in, bit-reversed order out
+    void ntt_forward(const ntt_prime& q, limb_t* xs, const size_t n, const limb_t* tw)
+    {
+        for(size_t len = n / 2; len != 0; len /= 2) {
+            for(size_t start = 0; start < n; start += 2 * len) {
+                limb_t* const lo = xs + start;
+                limb_t* const hi = xs + start + len;
+
+                for(size_t j = 0; j < len; j++) {
+                    const limb_t u = lo[j];
+                    const limb_t v = hi[j];
+
+                    lo[j] = q.add(u, v);
+                    hi[j] = q.mont_mul(q.sub(u, v), tw[len + j]);
+                }
+            }
+        }
+    }
+
+    // Decimation in time: bit-reversed order in, natural order out, not scaled by n^-1
+    void ntt_inverse(const ntt_prime& q, limb_t* xs, const size_t n, const limb_t* tw)
+    {
+        for(size_t len = 1; len < n; len *= 2) {
+            for(size_t start = 0; start < n; start += 2 * len) {
+                limb_t* const lo = xs + start;
+                limb_t* const hi = xs + start + len;
+
+                for(size_t j = 0; j < len; j++) {
+                    const limb_t u = lo[j];
+                    const limb_t v = q.mont_mul(hi[j], tw[len + j]);
+
+                    lo[j] = q.add(u, v);
+                    hi[j] = q.sub(u, v);
+                }
+            }
+        }
+    }
+
+    void ntt_load(const ntt_prime& q, limb_t* xs, const size_t n, const limb_t* ap, const size_t an)
+    {
+        for(size_t i = 0; i < an; i++) {
+            // p > 2^60, so it's at most 15 subtractions away -- still cheaper than a division
+            limb_t x = ap[i];
+
+            while(x >= q.p) {
+                x -= q.p;
+            }
+
+            xs[i] = x;
+        }
+
+        std::fill(xs + an, xs + n, 0);
+    }
+
+    /**
+     * Cyclic convolution of the two numbers modulo the i-th prime, to `cs`.
+     *
+     * With `bp` being null, squares {ap, an} instead. Needs n limbs of scratch at `tp` unless squaring.
+     */
+    void ntt_convolve(const size_t i_prime, limb_t* cs, const size_t n,
+                      const limb_t* ap, const size_t an, const limb_t* bp, const size_t bn, limb_t* tp)
+    {
+        const ntt_prime& q = prime(i_prime);
+
+        scratch_frame frame;
+        limb_t* const tw = frame.alloc(n);
+
+        ntt_twiddles(tw, q, n, false);
+
+        ntt_load(q, cs, n, ap, an);
+        ntt_forward(q, cs, n, tw);
+
+        if(bp != nullptr) {
+            ntt_load(q, tp, n, bp, bn);
+            ntt_forward(q, tp, n, tw);
+
+            for(size_t j = 0; j < n; j++) {
+                cs[j] = q.mont_mul(cs[j], tp[j]);
+            }
+        }
+        else {
+            for(size_t j = 0; j < n; j++) {
+                cs[j] = q.mont_mul(cs[j], cs[j]);
+            }
+        }
+
+        // The inverse ones take the forward ones' place
+        ntt_twiddles(tw, q, n, true);
+
+        ntt_inverse(q, cs, n, tw);
+
+        /*
+         * The pointwise products have picked up an extra R^-1, so the scale is n^-1 * R, which is what `mont_mul` of
+         * its Montgomery form (n^-1 * R^2) multiplies by.
+         */
+        const limb_t scale = q.to_mont(q.mont_pow(q.to_mont(n), q.p - 2));
+
+        for(size_t j = 0; j < n; j++) {
+            cs[j] = q.mont_mul(cs[j], scale);
+        }
+    }
+
+    /**
+     * Garner's algorithm for the three residues, with the constants in Montgomery form where it's multiplied by them
+     */
+    struct crt_consts
+    {
+        // p0^-1 mod p1, (p0 * p1)^-1 mod p2, p0 mod p2
+        limb_t inv_p0_p1, inv_p01_p2, p0_p2;
+
+        crt_consts()
+        {
+            const ntt_prime& q0 = prime(0);
+            const ntt_prime& q1 = prime(1);
+            const ntt_prime& q2 = prime(2);
+
+            const limb_t p0_mod_p1 = q0.p % q1.p;
+            const limb_t p0_mod_p2 = q0.p % q2.p;
+            const limb_t p1_mod_p2 = q1.p % q2.p;
+
+            // Inverses by Fermat's little theorem; x^(p - 2) stays in Montgomery form, so it's already what's needed
+            inv_p0_p1 = q1.mont_pow(q1.to_mont(p0_mod_p1), q1.p - 2);
+            inv_p01_p2 = q2.mont_pow(q2.mont_mul(q2.to_mont(p0_mod_p2), q2.to_mont(p1_mod_p2)), q2.p - 2);
+            p0_p2 = q2.to_mont(p0_mod_p2);
+        }
+    };
+
+    limb_t reduce(limb_t x, const limb_t p)
+    {
+        while(x >= p) {
+            x -= p;
+        }
+
+        return x;
+    }
+
+    void ntt_mul(limb_t* rp, const limb_t* ap, const size_t an, const limb_t* bp, const size_t bn)
+    {
+        static const crt_consts crt;
+
+        const size_t rn = an + (bp != nullptr ? bn : an);
+
+        size_t n = 1;
+
+        while(n < rn - 1) {
+            n *= 2;
+        }
+
+        // The convolutions share their scratch unless they run in parallel
+        const bool threads = use_threads(bp != nullptr ? bn : an);
+        const size_t n_scratch = bp == nullptr ? 0 : threads ? 3 : 1;
+
+        scratch_frame frame;
+
+        limb_t* const r0 = frame.alloc((3 + n_scratch) * n);
+        limb_t* const r1 = r0 + n;
+        limb_t* const r2 = r1 + n;
+
+        const auto convolve = [=](const size_t i) {
+            limb_t* const tp = bp != nullptr ? r2 + n + (threads ? i : 0) * n : nullptr;
+
+            ntt_convolve(i, r0 + i * n, n, ap, an, bp, bn, tp);
+        };
+
+        if(threads) {
+            run_parallel({ std::bind(convolve, 0), std::bind(convolve, 1), std::bind(convolve, 2) });
+        }
+        else {
+            for(size_t i = 0; i < 3; i++) {
+                convolve(i);
+            }
+        }
+
+        const ntt_prime& q1 = prime(1);
+        const ntt_prime& q2 = prime(2);
+
+        const limb_t p0 = prime(0).p;
+        const limb_t p1 = q1.p;
+
+        // What has carried out of the previous coefficients, in three limbs
+        limb_t carry[3] = { 0, 0, 0 };
+
+        for(size_t k = 0; k + 1 < rn; k++) {
+            /**
+             * c = v0 + p0 * (v1 + p1 * v2), with each v_i < p_i
+             */
+            const limb_t v0 = r0[k];
+            const limb_t v1 = q1.mont_mul(q1.sub(r1[k], reduce(v0, p1)), crt.inv_p0_p1);
+
+            const limb_t v01 = q2.add(reduce(v0, q2.p), q2.mont_mul(v1, crt.p0_p2));
+            const limb_t v2 = q2.mont_mul(q2.sub(r2[k], v01), crt.inv_p01_p2);
+
+            limb_t c[3];
+
+            // v1 + p1 * v2 < p1 * p2, so two limbs
+            const auto inner = mul_full(v2, p1);
+            c[0] = inner.first + v1;
+            c[1] = inner.second + (c[0] < v1);
+
+            c[2] = mul_1(c, c, 2, p0);
+            add_1(c, c, 3, v0);
+
+            add_n(carry, carry, c, 3);
+
+            rp[k] = carry[0];
+
+            carry[0] = carry[1];
+            carry[1] = carry[2];
+            carry[2] = 0;
+        }
+
+        // Whatever's left has to fit the last limb
+        rp[rn - 1] = carry[0];
+    }
+}
+
+void mul_ntt(limb_t* rp, const limb_t* ap, const size_t an, const limb_t* bp, const size_t bn)
+{
+    ntt_mul(rp, ap, an, bp, bn);
+}
+
+void sqr_ntt(limb_t* rp, const limb_t* ap, const size_t n)
+{
+    ntt_mul(rp, ap, n, nullptr, 0);
+}
+
+}
+}
@@ -0,0 +1,57 @@
+
+#include "mpn.hpp"
+
+#include <algorithm>
+#include <memory>
+
+#include "thread_pool.hpp"
+
+namespace isg {
+namespace mpn {
+
+namespace
+{
+    // Null while the parallel mode is off. Only ever accessed atomically: the products that are running hold on to the
+    // one they started with, which goes away when the last of them is done with it.
+    std::shared_ptr<thread_pool> pool;
+}
+
+void set_max_threads(unsigned n)
+{
+    if(n == 0) {
+        n = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    // The calling thread is one of them
+    std::atomic_store(&pool, n > 1 ? std::make_shared<thread_pool>(n - 1) : std::shared_ptr<thread_pool>());
+}
+
+unsigned max_threads()
+{
+    const std::shared_ptr<thread_pool> p = std::atomic_load(&pool);
+
+    return p ? p->n_threads() : 1;
+}
+
+bool use_threads(const size_t bn)
+{
+    return bn >= MUL_PARALLEL_THRESHOLD && std::atomic_load(&pool);
+}
+
+void run_parallel(const std::vector<std::function<void()>>& tasks)
+{
+    // Whatever `set_max_threads` does meanwhile, this one stays until the batch is done
+    const std::shared_ptr<thread_pool> p = std::atomic_load(&pool);
+
+    if(p) {
+        p->run(tasks);
+    }
+    else {
+        for(const auto& task : tasks) {
+            task();
+        }
+    }
+}
+
+}
+}
@@ -0,0 +1,90 @@
+
+#include "mpn.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace isg {
+namespace mpn {
+
+namespace
+{
+    // The first block's size: enough for the scratch of products up to a few thousand bits
+    constexpr size_t MIN_BLOCK_LIMBS = 1024;
+
+    /**
+     * A stack of blocks, of which the ones past the top one are free. A request that doesn't fit what's left of the top
+     * block moves on to the next one, which is replaced with a bigger one if it's too small -- nothing lives in it yet.
+     */
+    struct arena
+    {
+        std::vector<std::unique_ptr<limb_t[]>> blocks;
+        std::vector<size_t> sizes;
+
+        // The top block and how many of its limbs are taken
+        size_t block = 0;
+        size_t used = 0;
+
+        limb_t* alloc(const size_t n)
+        {
+            if(!blocks.empty() && sizes[block] - used >= n) {
+                limb_t* const p = blocks[block].get() + used;
+                used += n;
+
+                return p;
+            }
+
+            const size_t next = blocks.empty() ? 0 : block + 1;
+
+            if(next == blocks.size()) {
+                const size_t size = std::max(n, blocks.empty() ? MIN_BLOCK_LIMBS : 2 * sizes.back());
+
+                blocks.emplace_back(new limb_t[size]);
+                sizes.push_back(size);
+            }
+            else if(sizes[next] < n) {
+                const size_t size = std::max(n, 2 * sizes[next]);
+
+                blocks[next].reset(new limb_t[size]);
+                sizes[next] = size;
+            }
+
+            block = next;
+            used = n;
+
+            return blocks[block].get();
+        }
+    };
+
+    arena& thread_arena()
+    {
+        static thread_local arena a;
+
+        return a;
+    }
+}
+
+scratch_frame::scratch_frame()
+{
+    const arena& a = thread_arena();
+
+    block = a.block;
+    used = a.used;
+}
+
+scratch_frame::~scratch_frame()
+{
+    arena& a = thread_arena();
+
+    a.block = block;
+    a.used = used;
+}
+
+limb_t* scratch_frame::alloc(const size_t n)
+{
+    return thread_arena().alloc(n);
+}
+
+}
+}
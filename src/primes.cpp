@@ -1,38 +1,296 @@
 
 #include "primes.hpp"
 
+#include <algorithm>
 #include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "mpn.hpp"
+#include "montgomery_ctx.hpp"
+#include "modint.hpp"
 
 namespace isg
 {
 
+namespace
+{
+    bool is_prime_by_division(const uint32_t p)
+    {
+        if(p < 2 || (p % 2 == 0 && p != 2)) {
+            return false;
+        }
+
+        for(uint32_t d = 3; d * d <= p; d += 2) {
+            if(p % d == 0) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * The primes of P_SMALL_PRIMES (3 to 743), grouped so that each group's product fits in a limb, and the groups'
+     * products as divisors
+     */
+    struct small_prime_table
+    {
+        std::vector<uint32_t> primes;
+
+        std::vector<mpn::divisor_1> products;
+        // Where each group's primes end
+        std::vector<size_t> ends;
+
+        small_prime_table()
+        {
+            mpn::limb_t product = 1;
+
+            for(uint32_t p = 3; p <= 743; p += 2) {
+                if(!is_prime_by_division(p)) {
+                    continue;
+                }
+
+                if(product > UINT64_MAX / p) {
+                    products.emplace_back(product);
+                    ends.push_back(primes.size());
+
+                    product = 1;
+                }
+
+                primes.push_back(p);
+                product *= p;
+            }
+
+            products.emplace_back(product);
+            ends.push_back(primes.size());
+        }
+    };
+
+    const small_prime_table& small_primes()
+    {
+        static const small_prime_table table;
+
+        return table;
+    }
+
+    /**
+     * The rest of the strong test once x = a^q mod n is known, for n - 1 = q * 2^s with an odd q: passes if x = 1, or
+     * if it gets to n - 1 within s - 1 squares.
+     */
+    bool is_strong_probable_prime(const intbig_t& x, const intbig_t& n_dec, const uint64_t s,
+                                  const montgomery_ctx& n_ctx)
+    {
+        if(x == 1 || x == n_dec) {
+            return true;
+        }
+
+        // Squared in Montgomery's form, where n - 1 can be compared against as well
+        modint<montgomery_ctx> y(n_ctx, x);
+        const modint<montgomery_ctx> minus_one(n_ctx, n_dec);
+
+        for(uint64_t i = 1; i < s; i++) {
+            if(y.square() == minus_one) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+}
+
+small_residues::small_residues(const intbig_t& x)
+{
+    const small_prime_table& table = small_primes();
+
+    mpn::scratch_frame frame;
+    mpn::limb_t* const product_rs = frame.alloc(table.products.size());
+
+    mpn::mod_1_many(product_rs, x.limbs.data(), x.limbs.size(), table.products.data(), table.products.size());
+
+    rs.resize(table.primes.size());
+
+    for(size_t g = 0, i = 0; g < table.products.size(); g++) {
+        for(; i < table.ends[g]; i++) {
+            rs[i] = uint32_t(product_rs[g] % table.primes[i]);
+        }
+    }
+}
+
+const std::vector<uint32_t>& small_residues::primes()
+{
+    return small_primes().primes;
+}
+
+void small_residues::advance(const uint32_t delta)
+{
+    const std::vector<uint32_t>& ps = primes();
+
+    for(size_t i = 0; i < rs.size(); i++) {
+        const uint64_t r = uint64_t(rs[i]) + delta;
+
+        rs[i] = uint32_t(r < ps[i] ? r : r % ps[i]);
+    }
+}
+
+bool small_residues::any_zero() const
+{
+    return std::find(rs.begin(), rs.end(), 0) != rs.end();
+}
+
 bool prime_finder::test_prime_mr(const intbig_t& n)
 {
+    if(!n.test_bit(0)) {
+        return n == 2;
+    }
+
     const intbig_t n_dec = n - 1;
 
     const uint64_t coef2 = n_dec.factor2();
 
     // TODO: This has to be non-zero! Ensure either here or inside the method.
     const intbig_t a_random = intbig_t::random_lte(n_dec);
-    intbig_t q = n_dec >> coef2;
+    const intbig_t q = n_dec >> coef2;
 
-    if(a_random.at_power(q, n) == 1) {
-        return true;
+    // a^q, then its squares up to a^(n - 1) -- all modulo the same `n`
+    const montgomery_ctx n_ctx(n);
+
+    return is_strong_probable_prime(a_random.at_power(q, n_ctx), n_dec, coef2, n_ctx);
+}
+
+bool prime_finder::test_prime_sprp2(const intbig_t& n)
+{
+    if(!n.test_bit(0) || n == 1) {
+        return n == 2;
     }
 
-    for(uint64_t i = 0; i < coef2; i++) {
-        if(a_random.at_power(q, n) == n_dec) {
-            return true;
+    const intbig_t n_dec = n - 1;
+
+    const uint64_t coef2 = n_dec.factor2();
+    const intbig_t q = n_dec >> coef2;
+
+    const montgomery_ctx n_ctx(n);
+
+    return is_strong_probable_prime(intbig_t::pow2_mod(q, n_ctx), n_dec, coef2, n_ctx);
+}
+
+std::vector<bool> prime_finder::test_prime_sprp2(const std::vector<intbig_t>& ns)
+{
+    std::vector<bool> passed(ns.size());
+
+    // One by one, `pow2_mod` is cheaper than a power of 2 like any other
+    if(mpn::current_kernels() != mpn::kernels::avx512_ifma) {
+        for(size_t i = 0; i < ns.size(); i++) {
+            passed[i] = test_prime_sprp2(ns[i]);
+        }
+
+        return passed;
+    }
+
+    // 2^q for each n - 1 = q * 2^s with an odd q, all at once, then the squares one by one
+    std::vector<size_t> is;
+    std::vector<intbig_t> twos, qs, ms;
+    std::vector<uint64_t> coefs2;
+
+    for(size_t i = 0; i < ns.size(); i++) {
+        const intbig_t& n = ns[i];
+
+        if(!n.test_bit(0) || n == 1) {
+            passed[i] = n == 2;
+            continue;
+        }
+
+        const intbig_t n_dec = n - 1;
+
+        is.push_back(i);
+        coefs2.push_back(n_dec.factor2());
+
+        twos.push_back(intbig_t::of(2));
+        qs.push_back(n_dec >> coefs2.back());
+        ms.push_back(n);
+    }
+
+    const std::vector<intbig_t> xs = intbig_t::power_mod_batch(twos, qs, ms);
+
+    for(size_t j = 0; j < is.size(); j++) {
+        const montgomery_ctx n_ctx(ms[j]);
+
+        passed[is[j]] = is_strong_probable_prime(xs[j], ms[j] - 1, coefs2[j], n_ctx);
+    }
+
+    return passed;
+}
+
+std::vector<intbig_t> prime_finder::screen_small_factors(const std::vector<intbig_t>& candidates) const
+{
+    std::vector<intbig_t> passed;
+
+    for(const intbig_t& x : candidates) {
+        if(!small_residues(x).any_zero()) {
+            passed.push_back(x);
+        }
+    }
+
+    return passed;
+}
+
+size_t prime_finder::find_prime(const std::vector<intbig_t>& block, const size_t n_bits)
+{
+    const std::vector<bool> passed_sprp2 = test_prime_sprp2(block);
+
+    for(size_t i = 0; i < block.size(); i++) {
+        if(!passed_sprp2[i]) {
+            continue;
         }
 
-        q <<= 1;
+        bool is_composite = false;
+
+        // TODO: Determine an appropriate number of iterations
+        for(int j = 0; j < num_mr_checks(n_bits); j++) {
+            if(!test_prime_mr(block[i])) {
+                is_composite = true;
+                break;
+            }
+
+            if(print_feedback) {
+                std::cerr << '+' << std::flush;
+            }
+        }
+
+        if(!is_composite) {
+            if(print_feedback) {
+                std::cerr << '*' << std::endl;
+            }
+
+            return i;
+        }
     }
 
-    return false;
+    return block.size();
 }
 
 intbig_t prime_finder::random_prime(const size_t n_bits)
 {
+    if(n_bits < 2) {
+        throw std::logic_error("No primes of fewer than 2 bits");
+    }
+
+    // The sieve throws out the small primes themselves, which is most or all of the ones this short
+    if(n_bits <= 10) {
+        std::vector<uint32_t> ps;
+
+        for(uint32_t p = uint32_t(1) << (n_bits - 1); p < uint32_t(1) << n_bits; p++) {
+            if(is_prime_by_division(p)) {
+                ps.push_back(p);
+            }
+        }
+
+        // There are two at least, 2 and 3 being the fewest
+        const intbig_t i = intbig_t::random_lte(intbig_t::of(int64_t(ps.size() - 1)));
+
+        return intbig_t::of(ps[i.limbs.empty() ? 0 : size_t(i.limbs[0])]);
+    }
+
     // TODO: Parallelize into several threads?
 
     while(true) {
@@ -42,39 +300,50 @@ intbig_t prime_finder::random_prime(const size_t n_bits)
             x += 1;
         }
 
-        if(x.gcd(P_SMALL_PRIMES) != 1) {
-            continue;
-        }
+        small_residues rs(x);
 
-        if(print_feedback) {
-            std::cerr << '.' << std::flush;
-        }
+        /**
+         * The survivors of the sieve, in order, for the base-2 test to take at once: a batch of powers on IFMA costs
+         * little more than one of them. Otherwise there's nothing to gain by waiting, and each one is tested right away.
+         */
+        const size_t block_size = mpn::current_kernels() == mpn::kernels::avx512_ifma ? mpn::POWER_BATCH_LANES : 1;
+        std::vector<intbig_t> block;
 
-        {
-            bool is_composite = false;
+        for(size_t i = 0; i < SIEVE_STEPS; i++, x += 2, rs.advance(2)) {
+            // Past 2^n_bits, it's another start that's needed
+            if(x.num_bits() > n_bits) {
+                break;
+            }
 
-            // TODO: Determine an appropriate number of iterations
-            for(int i = 0; i < num_mr_checks(n_bits); i++) {
-                if(!test_prime_mr(x)) {
-                    is_composite = true;
-                    break;
-                }
+            if(rs.any_zero()) {
+                continue;
+            }
 
-                if(print_feedback) {
-                    std::cerr << '+' << std::flush;
-                }
+            if(print_feedback) {
+                std::cerr << '.' << std::flush;
             }
 
-            if(is_composite) {
+            block.push_back(x);
+
+            if(block.size() < block_size) {
                 continue;
             }
-        }
 
-        if(print_feedback) {
-            std::cerr << '*' << std::endl;
+            const size_t found = find_prime(block, n_bits);
+
+            if(found < block.size()) {
+                return block[found];
+            }
+
+            block.clear();
         }
 
-        return x;
+        // The rest of them, if any
+        const size_t found = find_prime(block, n_bits);
+
+        if(found < block.size()) {
+            return block[found];
+        }
     }
 }
 
@@ -24,7 +24,10 @@ std::pair<key_pub, key_priv> gen_keypair(const size_t l_mod, const intbig_t& e)
 
     const intbig_t n = p * q;
 
-    const intbig_t lambda_n = (p - 1) * (q - 1) / (p - 1).gcd(q - 1);
+    // lcm(p - 1, q - 1), where the gcd surely divides p - 1
+    intbig_t lambda_n = p - 1;
+    lambda_n.divexact(lambda_n.gcd(q - 1));
+    lambda_n *= q - 1;
 
     const intbig_t d = e.inverse_mod(lambda_n);
 
@@ -42,10 +45,8 @@ std::string calculate_hash(const std::string& msg, hash_sel_t hash)
 }
 
 key_pub::key_pub(const std::string& e_bytes, const std::string& n_bytes)
-{
-    e = intbig_t::from(e_bytes, intbig_t::Base256);
-    n = intbig_t::from(n_bytes, intbig_t::Base256);
-}
+        : key_pub(intbig_t::from(e_bytes, intbig_t::Base256), intbig_t::from(n_bytes, intbig_t::Base256))
+{ }
 
 std::string key_pub::e_bytes() const
 {
@@ -125,7 +126,7 @@ std::string key_pub::encrypt(const std::string& msg) const
         throw std::range_error("Message doesn't fit the modulus");
     }
 
-    x_msg.to_power(e, n);
+    x_msg.to_power(e, n_ctx);
 
     return x_msg.to_string(intbig_t::Base256);
 }
@@ -162,10 +163,8 @@ bool key_pub::verify_pkcs(const std::string& msg, const std::string& sig, hash_s
 }
 
 key_priv::key_priv(const std::string& d_bytes, const std::string& n_bytes)
-{
-    d = intbig_t::from(d_bytes, intbig_t::Base256);
-    n = intbig_t::from(n_bytes, intbig_t::Base256);
-}
+        : key_priv(intbig_t::from(d_bytes, intbig_t::Base256), intbig_t::from(n_bytes, intbig_t::Base256))
+{ }
 
 std::string key_priv::d_bytes() const
 {
@@ -225,7 +224,8 @@ std::string key_priv::decrypt(const std::string& msg) const
         throw std::range_error("Ciphertext doesn't fit the modulus");
     }
 
-    x_msg.to_power(d, n);
+    // `d` is secret, so neither the time nor the memory read may depend on its bits (`sign_pkcs` comes here too)
+    x_msg.to_power_sec(d, n_ctx);
 
     return x_msg.to_string(intbig_t::Base256);
 }
@@ -0,0 +1,90 @@
+
+#include "thread_pool.hpp"
+
+namespace isg
+{
+
+thread_pool::thread_pool(const unsigned n_workers)
+{
+    for(unsigned i = 0; i < n_workers; i++) {
+        workers.emplace_back(&thread_pool::worker_loop, this);
+    }
+}
+
+thread_pool::~thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+
+    changed.notify_all();
+
+    for(std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void thread_pool::run_task(std::unique_lock<std::mutex>& lock, const task& t)
+{
+    lock.unlock();
+    (*t.f)();
+    lock.lock();
+
+    if(--t.b->n_left == 0) {
+        changed.notify_all();
+    }
+}
+
+void thread_pool::worker_loop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while(true) {
+        changed.wait(lock, [this] { return stopping || !queue.empty(); });
+
+        if(queue.empty()) {
+            return;
+        }
+
+        const task t = queue.front();
+        queue.pop_front();
+
+        run_task(lock, t);
+    }
+}
+
+void thread_pool::run(const std::vector<std::function<void()>>& tasks)
+{
+    if(tasks.empty()) {
+        return;
+    }
+
+    batch b = { tasks.size() };
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    // All but the first one are up for grabs, that one's for this thread
+    for(size_t i = 1; i < tasks.size(); i++) {
+        queue.push_back({ &tasks[i], &b });
+    }
+
+    changed.notify_all();
+
+    run_task(lock, { &tasks[0], &b });
+
+    // Help out with the queue -- with this batch's tasks or anyone else's -- until this batch is done
+    while(b.n_left != 0) {
+        if(!queue.empty()) {
+            const task t = queue.front();
+            queue.pop_front();
+
+            run_task(lock, t);
+        }
+        else {
+            changed.wait(lock);
+        }
+    }
+}
+
+}
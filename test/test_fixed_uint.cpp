@@ -0,0 +1,153 @@
+#include <vector>
+#include <random>
+
+#include "gtest/gtest.h"
+
+#include "intbig_t.h"
+#include "mpn.hpp"
+#include "montgomery_ctx.hpp"
+#include "fixed_uint.hpp"
+
+#include "test_numbers.hpp"
+
+/*
+ * Tests for the fixed-length numbers: the conversions, the additions and the comparisons against `intbig_t`'s, and the
+ * Montgomery products and powers against `montgomery_ctx`'s, for the RSA sizes and a few small ones.
+ */
+
+namespace FixedUint
+{
+
+using isg::mpn::limb_t;
+using isg::fixed_uint;
+using isg::fixed_montgomery_ctx;
+
+namespace TestData
+{
+// Of at most `n` limbs, exactly `n` if `full`
+intbig_t random_number(std::mt19937_64& gen, const size_t n, const bool special, const bool full)
+{
+    return TestNumbers::random_number(gen, full ? n : size_t(gen() % (n + 1)), special);
+}
+}
+
+template<size_t Bits>
+void check_arithmetic(std::mt19937_64& gen)
+{
+    typedef fixed_uint<Bits> uint_t;
+
+    const intbig_t b_all = intbig_t::of(1) << int64_t(Bits);
+
+    for(int i = 0; i < 20; i++) {
+        const intbig_t a = TestData::random_number(gen, uint_t::N, i % 3 == 0, false);
+        const intbig_t b = TestData::random_number(gen, uint_t::N, i % 2 == 0, i % 4 == 0);
+
+        ASSERT_EQ(uint_t::from(a).to_intbig(), a) << a;
+        ASSERT_EQ(uint_t::from(a).num_bits(), a.num_bits()) << a;
+        ASSERT_EQ(uint_t::from(a).test_bit(0), a.test_bit(0)) << a;
+
+        uint_t x = uint_t::from(a);
+        const limb_t carry = x.add(uint_t::from(b));
+
+        ASSERT_EQ(x.to_intbig(), (a + b) % b_all) << a << " " << b;
+        ASSERT_EQ(carry, limb_t(a + b >= b_all)) << a << " " << b;
+
+        x = uint_t::from(a);
+        const limb_t borrow = x.sub(uint_t::from(b));
+
+        ASSERT_EQ(x.to_intbig(), (a - b + b_all) % b_all) << a << " " << b;
+        ASSERT_EQ(borrow, limb_t(a < b)) << a << " " << b;
+
+        x = uint_t::from(a);
+
+        ASSERT_EQ(x.cnd_sub(0, uint_t::from(b)), 0u) << a << " " << b;
+        ASSERT_EQ(x.to_intbig(), a) << a << " " << b;
+
+        x = uint_t::from(a);
+
+        ASSERT_EQ(x.cnd_sub(1, uint_t::from(b)), limb_t(a < b)) << a << " " << b;
+        ASSERT_EQ(x.to_intbig(), (a - b + b_all) % b_all) << a << " " << b;
+
+        ASSERT_EQ(uint_t::from(a).cmp(uint_t::from(b)), a < b ? -1 : a > b ? 1 : 0) << a << " " << b;
+        ASSERT_EQ(uint_t::from(a) == uint_t::from(b), a == b) << a << " " << b;
+    }
+
+    ASSERT_THROW(uint_t::from(b_all), std::range_error);
+    ASSERT_THROW(uint_t::from(intbig_t::of(-1)), std::range_error);
+}
+
+// With a power by a full-length exponent per modulus, the largest sizes take fewer of them
+template<size_t Bits>
+void check_montgomery(std::mt19937_64& gen, const int n_moduli)
+{
+    typedef fixed_uint<Bits> uint_t;
+
+    const intbig_t b_all = intbig_t::of(1) << int64_t(Bits);
+
+    for(int i = 0; i < n_moduli; i++) {
+        const intbig_t m = TestNumbers::random_odd_modulus(gen, uint_t::N, i);
+
+        const fixed_montgomery_ctx<Bits> fixed_ctx(uint_t::from(m));
+        const isg::montgomery_ctx ctx(m);
+
+        const intbig_t a = TestData::random_number(gen, uint_t::N, i % 2 == 0, false) % m;
+        const intbig_t b = TestData::random_number(gen, uint_t::N, false, false) % m;
+
+        const uint_t a_mont = fixed_ctx.to_mont(uint_t::from(a));
+        const uint_t b_mont = fixed_ctx.to_mont(uint_t::from(b));
+
+        ASSERT_EQ(a_mont.to_intbig(), ctx.to_mont(a)) << a << " " << m;
+        ASSERT_EQ(fixed_ctx.from_mont(a_mont).to_intbig(), a) << a << " " << m;
+
+        // Not below m, which any x of N limbs may be
+        for(const intbig_t& x : { m, m + a < b_all ? m + a : m, b_all - 1 }) {
+            const uint_t x_mont = fixed_ctx.to_mont(uint_t::from(x));
+
+            ASSERT_EQ(x_mont.to_intbig(), ctx.to_mont(x)) << x << " " << m;
+            ASSERT_EQ(fixed_ctx.from_mont(x_mont).to_intbig(), x % m) << x << " " << m;
+        }
+
+        ASSERT_EQ(fixed_ctx.from_mont(fixed_ctx.mul(a_mont, b_mont)).to_intbig(), a * b % m) << a << " " << b;
+        ASSERT_EQ(fixed_ctx.from_mont(fixed_ctx.sqr(a_mont)).to_intbig(), a * a % m) << a << " " << m;
+
+        // Short and full-length exponents, and the bounds
+        const intbig_t e_short = TestData::random_number(gen, 1, i % 2 == 0, false);
+        const intbig_t e_full = TestData::random_number(gen, uint_t::N, i % 2 == 0, i % 4 < 2);
+
+        for(const intbig_t& e : { e_short, e_full, intbig_t(), intbig_t::of(1), intbig_t::of(65537) }) {
+            const intbig_t expected = a.at_power(e, ctx);
+
+            ASSERT_EQ(fixed_ctx.power(uint_t::from(a), e).to_intbig(), expected) << a << " " << e << " " << m;
+            ASSERT_EQ(fixed_ctx.power_sec(uint_t::from(a), uint_t::from(e)).to_intbig(), expected)
+                    << a << " " << e << " " << m;
+        }
+    }
+
+    ASSERT_THROW(fixed_montgomery_ctx<Bits>(uint_t::of(2)), std::logic_error);
+}
+
+class FixedUint : public testing::Test
+{
+protected:
+    std::mt19937_64 gen{ 1 };
+};
+
+TEST_F(FixedUint, ArithmeticMatchesIntBig) {
+    check_arithmetic<64>(gen);
+    check_arithmetic<128>(gen);
+    check_arithmetic<1024>(gen);
+    check_arithmetic<2048>(gen);
+    check_arithmetic<3072>(gen);
+    check_arithmetic<4096>(gen);
+}
+
+TEST_F(FixedUint, MontgomeryMatchesContext) {
+    check_montgomery<64>(gen, 10);
+    check_montgomery<192>(gen, 10);
+    check_montgomery<1024>(gen, 5);
+    check_montgomery<2048>(gen, 3);
+    check_montgomery<3072>(gen, 2);
+    check_montgomery<4096>(gen, 2);
+}
+
+}
@@ -0,0 +1,541 @@
+#include <algorithm>
+#include <vector>
+#include <random>
+#include <tuple>
+
+#include "gtest/gtest.h"
+
+#include "intbig_t.h"
+#include "mpn.hpp"
+#include "barrett_ctx.hpp"
+#include "montgomery_ctx.hpp"
+
+#include "test_numbers.hpp"
+
+/*
+ * Tests for the long division: the quotient and the remainder are checked against q * d + r = n and 0 <= r < d, the
+ * divide-and-conquer division against the schoolbook one, and the exact and single-limb divisions and Barrett's and
+ * Montgomery's reductions against the long one.
+ *
+ * Besides random ones, the operands are made of the limbs where the quotient's estimates go wrong the most often, like
+ * all-ones and the halves of the base.
+ */
+
+namespace IntBigTDiv
+{
+
+using isg::mpn::limb_t;
+
+namespace TestData
+{
+// { nn, dn }
+const std::vector<std::pair<size_t, size_t>> sizes = {
+        { 1, 1 }, { 2, 1 }, { 7, 1 },
+        { 2, 2 }, { 3, 2 }, { 8, 2 },
+        { 5, 4 }, { 8, 4 }, { 20, 7 },
+        { 32, 16 }, { 64, 32 }, { 100, 99 }, { 130, 31 },
+        { 80, 40 }, { 150, 41 }, { 200, 97 }, { 700, 300 }
+};
+
+// { nn, dn } for the algorithms under `divrem`: balanced, deeper recursion, and quotients of whole and partial blocks
+const std::vector<std::pair<size_t, size_t>> dc_sizes = {
+        { 8, 4 }, { 9, 5 }, { 80, 40 }, { 81, 41 }, { 200, 100 }, { 161, 80 }, { 300, 80 }, { 333, 111 },
+        { 1000, 150 }, { 1500, 700 }
+};
+
+// { n, d, n / d, n % d }: the quotient is truncated, the remainder takes the dividend's sign
+const std::vector<std::tuple<std::string, std::string, std::string, std::string>> sign_cases = {
+        { "100000000000000000000000000007", "10000000000000000000", "10000000000", "7" },
+        { "-100000000000000000000000000007", "10000000000000000000", "-10000000000", "-7" },
+        { "100000000000000000000000000007", "-10000000000000000000", "-10000000000", "7" },
+        { "-100000000000000000000000000007", "-10000000000000000000", "10000000000", "-7" },
+        { "5", "10000000000000000000000", "0", "5" },
+        { "-5", "10000000000000000000000", "0", "-5" },
+        { "0", "-3", "0", "0" },
+        { "-36893488147419103232", "18446744073709551616", "-2", "0" }
+};
+
+using TestNumbers::to_intbig;
+using TestNumbers::random_number;
+}
+
+class IntBigTDivSizes : public testing::TestWithParam<std::pair<size_t, size_t>> { };
+
+TEST_P(IntBigTDivSizes, QuotientAndRemainderAddUp) {
+    std::mt19937_64 gen(GetParam().first * 1000 + GetParam().second);
+
+    for(int i = 0; i < 200; i++) {
+        const intbig_t n = TestData::random_number(gen, GetParam().first, i % 2 == 0);
+        const intbig_t d = TestData::random_number(gen, GetParam().second, i % 4 < 2);
+
+        intbig_t q = n;
+        const intbig_t r = q.divmod(d);
+
+        ASSERT_TRUE(r >= 0 && r < d) << n << " " << d;
+        ASSERT_EQ(q * d + r, n) << n << " " << d;
+
+        ASSERT_EQ(n / d, q) << n << " " << d;
+        ASSERT_EQ(n % d, r) << n << " " << d;
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(Sizes, IntBigTDivSizes, testing::ValuesIn(TestData::sizes));
+
+class IntBigTDivDC : public testing::TestWithParam<std::pair<size_t, size_t>> { };
+
+TEST_P(IntBigTDivDC, MatchesSchoolbook) {
+    std::mt19937_64 gen(GetParam().first * 1000 + GetParam().second);
+
+    const size_t nn = GetParam().first;
+    const size_t dn = GetParam().second;
+
+    for(int i = 0; i < 10; i++) {
+        std::vector<limb_t> n = TestData::random_number(gen, nn, i % 2 == 0).limbs;
+        std::vector<limb_t> d = TestData::random_number(gen, dn, i % 4 < 2).limbs;
+
+        n.resize(nn);
+        d.back() |= limb_t(1) << 63;
+
+        // Ones where the top of `n` is `d` itself, or just below it
+        if(i == 2 || i == 3) {
+            std::copy(d.begin(), d.end(), n.end() - dn);
+
+            if(i == 3 && n[nn - dn] != 0) {
+                n[nn - dn] -= 1;
+            }
+        }
+
+        std::vector<limb_t> q_sb(nn - dn), q_dc(nn - dn);
+        std::vector<limb_t> r_sb = n, r_dc = n;
+
+        const limb_t qh_sb = isg::mpn::div_qr_schoolbook(q_sb.data(), r_sb.data(), nn, d.data(), dn);
+        const limb_t qh_dc = isg::mpn::div_qr_dc(q_dc.data(), r_dc.data(), nn, d.data(), dn);
+
+        ASSERT_EQ(qh_dc, qh_sb);
+        ASSERT_EQ(q_dc, q_sb);
+
+        r_sb.resize(dn);
+        r_dc.resize(dn);
+
+        ASSERT_EQ(r_dc, r_sb);
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(Sizes, IntBigTDivDC, testing::ValuesIn(TestData::dc_sizes));
+
+class IntBigTDivExact : public testing::TestWithParam<std::pair<size_t, size_t>> { };
+
+TEST_P(IntBigTDivExact, MatchesMultiplication) {
+    std::mt19937_64 gen(GetParam().first * 1000 + GetParam().second);
+
+    // Here, `first` is the size of the quotient
+    for(int i = 0; i < 50; i++) {
+        const intbig_t q = TestData::random_number(gen, GetParam().first, i % 2 == 0) * (i % 3 == 0 ? -1 : 1);
+        intbig_t d = TestData::random_number(gen, GetParam().second, i % 4 < 2) * (i % 5 == 0 ? -1 : 1);
+
+        // Even ones, down to whole zero limbs
+        if(i % 7 == 1) {
+            d <<= int64_t(gen() % (64 * 2 + 1));
+        }
+
+        intbig_t x = q * d;
+        x.divexact(d);
+
+        ASSERT_EQ(x, q) << q << " " << d;
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(Sizes, IntBigTDivExact, testing::ValuesIn(TestData::sizes));
+
+class IntBigTDivSigns : public testing::TestWithParam<std::tuple<std::string, std::string, std::string, std::string>>
+{
+protected:
+    intbig_t GetN() { return intbig_t::from(std::get<0>(GetParam())); }
+    intbig_t GetD() { return intbig_t::from(std::get<1>(GetParam())); }
+    std::string GetQ() { return std::get<2>(GetParam()); }
+    std::string GetR() { return std::get<3>(GetParam()); }
+};
+
+TEST_P(IntBigTDivSigns, DivmodInplace) {
+    intbig_t q = GetN();
+    const intbig_t r = q.divmod(GetD());
+
+    ASSERT_EQ(q.to_string(), GetQ());
+    ASSERT_EQ(r.to_string(), GetR());
+}
+
+TEST_P(IntBigTDivSigns, OperatorsInplace) {
+    intbig_t q = GetN();
+    intbig_t r = GetN();
+
+    q /= GetD();
+    r %= GetD();
+
+    ASSERT_EQ(q.to_string(), GetQ());
+    ASSERT_EQ(r.to_string(), GetR());
+}
+
+TEST_P(IntBigTDivSigns, OperatorsCopying) {
+    ASSERT_EQ((GetN() / GetD()).to_string(), GetQ());
+    ASSERT_EQ((GetN() % GetD()).to_string(), GetR());
+}
+
+INSTANTIATE_TEST_CASE_P(Signs, IntBigTDivSigns, testing::ValuesIn(TestData::sign_cases));
+
+class IntBigTDivLimb : public testing::TestWithParam<uint64_t> { };
+
+TEST_P(IntBigTDivLimb, MatchesLongDivision) {
+    std::mt19937_64 gen(GetParam());
+
+    const intbig_t d = TestData::to_intbig({ GetParam() });
+
+    for(size_t n = 0; n < 40; n++) {
+        const intbig_t x = TestData::random_number(gen, n, n % 2 == 0);
+
+        intbig_t q = x;
+        const uint64_t r = q.divmod(GetParam());
+
+        ASSERT_EQ(q, x / d) << x << " " << GetParam();
+        ASSERT_EQ(TestData::to_intbig({ r }), x % d) << x << " " << GetParam();
+
+        ASSERT_EQ(x.mod(GetParam()), r) << x << " " << GetParam();
+    }
+}
+
+TEST_P(IntBigTDivLimb, EachMatchesOneByOne) {
+    std::mt19937_64 gen(GetParam());
+
+    std::vector<intbig_t> xs;
+
+    for(size_t n = 0; n < 20; n++) {
+        xs.push_back(TestData::random_number(gen, n, n % 3 == 0));
+    }
+
+    const std::vector<uint64_t> rems = intbig_t::mod_each(xs, GetParam());
+
+    ASSERT_EQ(rems.size(), xs.size());
+
+    for(size_t i = 0; i < xs.size(); i++) {
+        ASSERT_EQ(rems[i], xs[i].mod(GetParam())) << xs[i] << " " << GetParam();
+    }
+}
+
+// Small ones, ones past 32 bits, powers of two, and the top-bit ones that need no normalization
+INSTANTIATE_TEST_CASE_P(Divisors, IntBigTDivLimb, testing::Values(
+        1, 2, 3, 10, 743, 1000000007, 4294967296ULL, 4294967311ULL, 10000000000000000000ULL,
+        1ULL << 63, (1ULL << 63) + 1, 18446744073709551557ULL, UINT64_MAX));
+
+TEST(IntBigTDivLimb, DecimalDigitChunks) {
+    // Around the powers of 10^19 that the conversion takes the digits by
+    for(const std::string s : { "9999999999999999999", "10000000000000000000", "10000000000000000001",
+                                "100000000000000000000000000000000000000", "-1000000000000000000900000000000000000007",
+                                "18446744073709551616" }) {
+        ASSERT_EQ(intbig_t::from(s).to_string(), s);
+    }
+}
+
+class IntBigTDivBarrett : public testing::TestWithParam<size_t> { };
+
+TEST_P(IntBigTDivBarrett, ReduceMatchesDivision) {
+    std::mt19937_64 gen(GetParam());
+
+    const size_t k = GetParam();
+
+    for(int i = 0; i < 20; i++) {
+        intbig_t m = TestData::random_number(gen, k, i % 2 == 0);
+
+        // Even ones, and a power of B, for which mu has an extra limb
+        if(i == 1) {
+            m = TestData::random_number(gen, k, false) << 1;
+        }
+        else if(i == 3) {
+            m = intbig_t::of(1) << int64_t(64 * (k - 1));
+        }
+
+        const isg::barrett_ctx ctx(m);
+
+        for(size_t xn = 0; xn <= 2 * ctx.size() + 2; xn++) {
+            const intbig_t x = TestData::random_number(gen, xn, xn % 2 == 0);
+
+            ASSERT_EQ(ctx.reduce(x), x % m) << x << " " << m;
+        }
+
+        const intbig_t a = TestData::random_number(gen, k, true) % m;
+        const intbig_t b = TestData::random_number(gen, k, false) % m;
+
+        ASSERT_EQ(ctx.mul_mod(a, b), a * b % m) << a << " " << b << " " << m;
+        ASSERT_EQ(a.times_mod(a, ctx), a * a % m) << a << " " << m;
+    }
+}
+
+TEST_P(IntBigTDivBarrett, PowerMatchesSquareAndMultiply) {
+    std::mt19937_64 gen(GetParam());
+
+    const intbig_t m = TestData::random_number(gen, GetParam(), false);
+    const intbig_t x = TestData::random_number(gen, GetParam(), false) % m;
+
+    // Around the lengths where the sliding window widens
+    for(const size_t e_bits : { 1, 2, 23, 24, 79, 80, 128, 240, 671, 672, 1000 }) {
+        const size_t e_limbs = (e_bits + 63) / 64;
+        const intbig_t e = (TestData::random_number(gen, e_limbs, false) >> int64_t(64 * e_limbs - e_bits))
+                           | (intbig_t::of(1) << int64_t(e_bits - 1));
+
+        intbig_t expected = intbig_t::of(1);
+
+        for(size_t i = e.num_bits(); i-- > 0; ) {
+            expected = expected * expected % m;
+
+            if(e.test_bit(i)) {
+                expected = expected * x % m;
+            }
+        }
+
+        ASSERT_EQ(x.at_power(e, isg::barrett_ctx(m)), expected) << e;
+        ASSERT_EQ(x.at_power(e, m), expected) << e;
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(Sizes, IntBigTDivBarrett, testing::Values(1, 2, 3, 8, 16, 32, 33, 64));
+
+class IntBigTDivMontgomery : public TestNumbers::ModulusTest { };
+
+TEST_P(IntBigTDivMontgomery, FormMatchesDivision) {
+    for(int i = 0; i < 20; i++) {
+        const intbig_t m = random_modulus(i);
+        const isg::montgomery_ctx ctx(m);
+
+        const int64_t r_bits = int64_t(64 * ctx.size());
+
+        for(size_t xn = 0; xn <= 2 * ctx.size() + 1; xn++) {
+            const intbig_t x = TestData::random_number(gen, xn, xn % 2 == 0);
+            const intbig_t x_mont = ctx.to_mont(x);
+
+            ASSERT_EQ(x_mont, (x << r_bits) % m) << x << " " << m;
+            ASSERT_EQ(ctx.from_mont(x_mont), x % m) << x << " " << m;
+        }
+    }
+}
+
+TEST_P(IntBigTDivMontgomery, ProductsMatchDivision) {
+    for(int i = 0; i < 20; i++) {
+        const intbig_t m = random_modulus(i);
+        const isg::montgomery_ctx ctx(m);
+
+        const intbig_t a = TestData::random_number(gen, GetParam(), i % 3 == 0) % m;
+        const intbig_t b = TestData::random_number(gen, GetParam() + i % 2, false);
+
+        ASSERT_EQ(ctx.mul_mod(a, b), a * b % m) << a << " " << b << " " << m;
+        ASSERT_EQ(ctx.from_mont(ctx.mul(ctx.to_mont(a), ctx.to_mont(b))), a * b % m) << a << " " << b << " " << m;
+        ASSERT_EQ(ctx.from_mont(ctx.sqr(ctx.to_mont(a))), a * a % m) << a << " " << m;
+    }
+}
+
+TEST_P(IntBigTDivMontgomery, PowerMatchesBarrett) {
+    for(int i = 0; i < 5; i++) {
+        const intbig_t m = random_modulus(i);
+        const intbig_t x = TestData::random_number(gen, GetParam() + 1, false);
+        const intbig_t e = TestData::random_number(gen, 1 + i % 3, i % 2 == 0);
+
+        const intbig_t expected = x.at_power(e, isg::barrett_ctx(m));
+
+        ASSERT_EQ(x.at_power(e, isg::montgomery_ctx(m)), expected) << x << " " << e << " " << m;
+        ASSERT_EQ(x.at_power(e, m), expected) << x << " " << e << " " << m;
+    }
+
+    // The smallest powers, and ones of zero
+    const intbig_t m = random_modulus(0);
+    const isg::montgomery_ctx ctx(m);
+
+    ASSERT_EQ(m.at_power(intbig_t::of(1), ctx), 0);
+    ASSERT_EQ((m + 2).at_power(intbig_t::of(1), ctx), intbig_t::of(2) % m);
+    ASSERT_EQ(intbig_t().at_power(intbig_t::of(5), ctx), 0);
+    ASSERT_EQ(intbig_t::of(7).at_power(intbig_t(), ctx), 1);
+}
+
+TEST_P(IntBigTDivMontgomery, FixedWindowMatchesSliding) {
+    for(int i = 0; i < 5; i++) {
+        const intbig_t m = random_modulus(i);
+        const isg::montgomery_ctx ctx(m);
+
+        const intbig_t x = TestData::random_number(gen, GetParam() + i % 2, false);
+
+        // Longer than the modulus too, and with the top window cut short for every width
+        for(const size_t en : { 1, 2, 3, 4, 11 }) {
+            const intbig_t e = TestData::random_number(gen, en, i % 2 == 0);
+
+            ASSERT_EQ(x.at_power_sec(e, ctx), x.at_power(e, ctx)) << x << " " << e << " " << m;
+        }
+    }
+
+    const intbig_t m = random_modulus(0);
+    const isg::montgomery_ctx ctx(m);
+
+    const intbig_t x = TestData::random_number(gen, GetParam(), false);
+
+    for(const int64_t e : { 0, 1, 2, 3, 64 }) {
+        ASSERT_EQ(x.at_power_sec(intbig_t::of(e), ctx), x.at_power(intbig_t::of(e), ctx)) << x << " " << e;
+    }
+
+    ASSERT_EQ(intbig_t().at_power_sec(intbig_t::of(5), ctx), 0);
+    ASSERT_EQ(x.at_power_sec(intbig_t::of(5), isg::montgomery_ctx(intbig_t::of(1))), 0);
+}
+
+TEST(IntBigTDivMontgomerySec, StaysOffSubquadratic) {
+    using isg::mpn::kernels;
+
+    const kernels initial = isg::mpn::current_kernels();
+    std::mt19937_64 gen{ 1 };
+
+    // At the sizes where the public powers switch to Karatsuba's products and squares without IFMA
+    for(const kernels ks : { kernels::portable, kernels::mulx_adx }) {
+        if(!isg::mpn::select_kernels(ks)) {
+            continue;
+        }
+
+        for(const size_t n : { 32, 64 }) {
+            const intbig_t m = TestNumbers::random_odd_modulus(gen, n, 1);
+            const isg::montgomery_ctx ctx(m);
+
+            const intbig_t x = TestData::random_number(gen, n, false) % m;
+            const intbig_t e = TestData::random_number(gen, n, false);
+
+            const size_t calls = isg::mpn::subquadratic_calls();
+            const intbig_t r = x.at_power_sec(e, ctx);
+
+            EXPECT_EQ(isg::mpn::subquadratic_calls(), calls) << n;
+
+            EXPECT_EQ(x.at_power(e, ctx), r) << n;
+            EXPECT_GT(isg::mpn::subquadratic_calls(), calls) << n;
+        }
+    }
+
+    isg::mpn::select_kernels(initial);
+}
+
+TEST_P(IntBigTDivMontgomery, MultiPowerMatchesProduct) {
+    for(int i = 0; i < 5; i++) {
+        const intbig_t m = random_modulus(i);
+
+        // Exponents of different lengths, whose windows end apart, and a base above the modulus
+        intbig_t::power_terms terms;
+
+        for(const size_t en : { 1, 3, 2 }) {
+            terms.emplace_back(TestData::random_number(gen, GetParam() + en % 2, false),
+                               TestData::random_number(gen, en, i % 2 == 0));
+        }
+
+        // Even moduli go by Barrett's reduction
+        for(const intbig_t& mod : { m, m + 1 }) {
+            intbig_t expected = intbig_t::of(1);
+
+            for(size_t t = 0; t < terms.size(); t++) {
+                expected = expected * terms[t].first.at_power(terms[t].second, mod) % mod;
+
+                const intbig_t::power_terms head(terms.begin(), terms.begin() + t + 1);
+
+                ASSERT_EQ(intbig_t::multi_power_mod(head, mod), expected) << mod;
+            }
+        }
+    }
+
+    // Terms of x^0 count as 1, and so do none at all
+    const intbig_t m = random_modulus(0);
+    const intbig_t x = TestData::random_number(gen, GetParam(), false);
+
+    ASSERT_EQ(intbig_t::multi_power_mod({ { x, intbig_t() }, { x + 1, intbig_t::of(3) } }, m),
+              (x + 1).at_power(intbig_t::of(3), m));
+    ASSERT_EQ(intbig_t::multi_power_mod({ { x, intbig_t() } }, m), 1);
+    ASSERT_EQ(intbig_t::multi_power_mod({ }, m), 1);
+    ASSERT_EQ(intbig_t::multi_power_mod({ { x, intbig_t::of(2) } }, intbig_t::of(1)), 0);
+
+    ASSERT_THROW(intbig_t::multi_power_mod({ { -x, intbig_t::of(2) } }, m), std::logic_error);
+    ASSERT_THROW(intbig_t::multi_power_mod({ { x, intbig_t::of(-2) } }, m), std::logic_error);
+}
+
+TEST_P(IntBigTDivMontgomery, BatchMatchesScalar) {
+    std::vector<intbig_t> xs, pows, ms;
+
+    // Two full batches and a partial one of this size, and a partial one of the next size among them
+    for(int i = 0; i < 25; i++) {
+        const intbig_t m = i % 5 == 3 ? (random_modulus(i) << 64) + 1 : random_modulus(i);
+        const size_t en = size_t(i % 4);
+
+        xs.push_back(TestData::random_number(gen, m.limbs.size() + (i % 3 == 0), i % 2 == 0));
+        pows.push_back(TestData::random_number(gen, en, i % 2 == 1));
+        ms.push_back(m);
+    }
+
+    // Where x is 0, and m is 1
+    xs[1] = intbig_t();
+    ms[2] = intbig_t::of(1);
+
+    const std::vector<intbig_t> rs = intbig_t::power_mod_batch(xs, pows, ms);
+
+    ASSERT_EQ(rs.size(), xs.size());
+
+    for(size_t i = 0; i < xs.size(); i++) {
+        ASSERT_EQ(rs[i], xs[i].at_power(pows[i], ms[i])) << xs[i] << " " << pows[i] << " " << ms[i];
+    }
+
+    ASSERT_TRUE(intbig_t::power_mod_batch({ }, { }, { }).empty());
+
+    ASSERT_THROW(intbig_t::power_mod_batch({ xs[0] }, { pows[0] }, { ms[0] + 1 }), std::logic_error);
+    ASSERT_THROW(intbig_t::power_mod_batch({ xs[0] }, { pows[0], pows[1] }, { ms[0] }), std::logic_error);
+}
+
+// The IFMA kernels' sizes included
+INSTANTIATE_TEST_CASE_P(Sizes, IntBigTDivMontgomery, testing::Values(1, 2, 3, 8, 16, 17, 32, 33, 64, 65));
+
+class IntBigTDivInverse : public testing::TestWithParam<size_t> { };
+
+TEST_P(IntBigTDivInverse, MatchesBezout) {
+    std::mt19937_64 gen(GetParam());
+
+    for(int i = 0; i < 30; i++) {
+        const intbig_t m = TestData::random_number(gen, GetParam(), i % 3 == 0) + (i % 2 == 0 ? 0 : 1);
+        const intbig_t a = TestData::random_number(gen, 1 + i % (GetParam() + 1), i % 4 == 0) * (i % 5 == 0 ? 6 : 1);
+
+        const intbig_t x = a.inverse_mod(m);
+
+        ASSERT_TRUE(x >= 0 && x < m) << a << " " << m << " " << x;
+
+        // Short of an inverse, it's still the coefficient of a in a * x + m * y = gcd(a, m)
+        ASSERT_EQ(a * x % m, a.gcd(m) % m) << a << " " << m << " " << x;
+
+        // A negative number's is that of its residue
+        const intbig_t y = (-a).inverse_mod(m);
+
+        ASSERT_EQ(y, ((m - a % m) % m).inverse_mod(m)) << a << " " << m;
+
+        if(a.gcd(m) == 1) {
+            ASSERT_EQ(((-a) * y % m + m) % m, intbig_t::of(1) % m) << a << " " << m << " " << y;
+        }
+    }
+
+    // m = 1 * m + 0 * m, and gcd(0, m) = 0 * 0 + 1 * m
+    const intbig_t m = TestData::random_number(gen, GetParam(), false);
+
+    ASSERT_EQ(m.inverse_mod(m), intbig_t::of(1));
+    ASSERT_EQ(intbig_t().inverse_mod(m), intbig_t());
+    ASSERT_THROW(m.inverse_mod(intbig_t()), std::logic_error);
+}
+
+INSTANTIATE_TEST_CASE_P(Sizes, IntBigTDivInverse, testing::Values(1, 2, 3, 8, 16, 33, 64));
+
+TEST(IntBigTDivZero, Throws) {
+    intbig_t x = intbig_t::of(12345);
+
+    ASSERT_THROW(x.divmod(intbig_t()), std::domain_error);
+    ASSERT_THROW(x /= intbig_t(), std::domain_error);
+    ASSERT_THROW(x %= intbig_t(), std::domain_error);
+    ASSERT_THROW(x.divexact(intbig_t()), std::domain_error);
+
+    ASSERT_THROW(x.divmod(uint64_t(0)), std::domain_error);
+    ASSERT_THROW(x.mod(0), std::domain_error);
+
+    ASSERT_THROW(isg::barrett_ctx{ intbig_t() }, std::logic_error);
+    ASSERT_THROW(isg::montgomery_ctx{ intbig_t() }, std::logic_error);
+    ASSERT_THROW(isg::montgomery_ctx{ intbig_t::of(1) << 64 }, std::logic_error);
+}
+
+}
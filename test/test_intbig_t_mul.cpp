@@ -0,0 +1,464 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <random>
+
+#include "gtest/gtest.h"
+
+#include "intbig_t.h"
+#include "mpn.hpp"
+
+/*
+ * Tests for the multiplication ladder: every algorithm above the schoolbook one is checked against it on random
+ * operands of the sizes around and above its threshold.
+ *
+ * The operands are all-ones as well as random, since that's where the carries run the longest.
+ */
+
+namespace IntBigTMul
+{
+
+using isg::mpn::limb_t;
+
+typedef void (*mul_fn)(limb_t*, const limb_t*, size_t, const limb_t*, size_t);
+
+// An algorithm and the operands' sizes to test it on
+struct mul_case
+{
+    mul_fn f;
+    size_t an, bn;
+};
+
+std::ostream& operator<<(std::ostream& os, const mul_case& c)
+{
+    return os << c.an << "x" << c.bn;
+}
+
+typedef void (*sqr_fn)(limb_t*, const limb_t*, size_t);
+
+struct sqr_case
+{
+    sqr_fn f;
+    size_t n;
+};
+
+std::ostream& operator<<(std::ostream& os, const sqr_case& c)
+{
+    return os << c.n;
+}
+
+namespace TestData
+{
+using namespace isg::mpn;
+
+const std::vector<mul_case> karatsuba_cases = {
+        { mul_karatsuba, 24, 24 }, { mul_karatsuba, 25, 24 }, { mul_karatsuba, 25, 14 }, { mul_karatsuba, 31, 17 },
+        { mul_karatsuba, 40, 40 }, { mul_karatsuba, 47, 46 }, { mul_karatsuba, 64, 33 }, { mul_karatsuba, 100, 99 },
+        { mul_karatsuba, 128, 128 }
+};
+
+// The Toom-Cook ones are tested at sizes well below their thresholds too -- they're correct for any that fit
+const std::vector<mul_case> toom33_cases = {
+        { mul_toom33, 9, 7 }, { mul_toom33, 30, 30 }, { mul_toom33, 31, 23 }, { mul_toom33, 200, 200 },
+        { mul_toom33, 250, 199 }, { mul_toom33, 301, 300 }
+};
+
+const std::vector<mul_case> toom44_cases = {
+        { mul_toom44, 16, 13 }, { mul_toom44, 40, 40 }, { mul_toom44, 43, 34 }, { mul_toom44, 500, 500 },
+        { mul_toom44, 611, 500 }, { mul_toom44, 1000, 999 }
+};
+
+const std::vector<mul_case> toom32_cases = {
+        { mul_toom32, 9, 6 }, { mul_toom32, 30, 20 }, { mul_toom32, 35, 20 }, { mul_toom32, 240, 160 },
+        { mul_toom32, 250, 199 }, { mul_toom32, 301, 170 }
+};
+
+const std::vector<mul_case> toom42_cases = {
+        { mul_toom42, 12, 6 }, { mul_toom42, 40, 20 }, { mul_toom42, 44, 17 }, { mul_toom42, 320, 160 },
+        { mul_toom42, 400, 170 }, { mul_toom42, 301, 161 }
+};
+
+// The transform's length is rounded up to a power of two, so both sides of one are tested
+const std::vector<mul_case> ntt_cases = {
+        { mul_ntt, 1, 1 }, { mul_ntt, 2, 1 }, { mul_ntt, 17, 16 }, { mul_ntt, 33, 32 }, { mul_ntt, 300, 7 },
+        { mul_ntt, 513, 512 }, { mul_ntt, 1000, 999 }, { mul_ntt, 2048, 2000 }
+};
+
+const std::vector<sqr_case> sqr_cases = {
+        { sqr_basecase, 1 }, { sqr_basecase, 2 }, { sqr_basecase, 3 }, { sqr_basecase, 31 }, { sqr_basecase, 100 },
+        { sqr_karatsuba, 2 }, { sqr_karatsuba, 3 }, { sqr_karatsuba, 32 }, { sqr_karatsuba, 33 }, { sqr_karatsuba, 101 },
+        { sqr_toom3, 5 }, { sqr_toom3, 7 }, { sqr_toom3, 250 }, { sqr_toom3, 301 }, { sqr_toom3, 599 },
+        { sqr_toom4, 13 }, { sqr_toom4, 18 }, { sqr_toom4, 600 }, { sqr_toom4, 601 }, { sqr_toom4, 1000 },
+        { sqr_ntt, 1 }, { sqr_ntt, 2 }, { sqr_ntt, 16 }, { sqr_ntt, 17 }, { sqr_ntt, 1025 },
+        { sqr, 1 }, { sqr, 40 }, { sqr, 300 }, { sqr, 700 }, { sqr, 7000 }
+};
+
+// { a's size, b's size } in limbs
+const std::vector<std::pair<size_t, size_t>> dispatch_sizes = {
+        { 1, 1 }, { 7, 3 }, { 23, 23 }, { 24, 12 }, { 49, 24 }, { 100, 30 }, { 200, 24 }, { 513, 77 }, { 300, 301 },
+        { 240, 160 }, { 320, 161 }, { 600, 590 }, { 1500, 700 }, { 12000, 10000 }
+};
+
+intbig_t to_intbig(std::vector<limb_t> xs)
+{
+    intbig_t x;
+
+    while(!xs.empty() && xs.back() == 0) {
+        xs.pop_back();
+    }
+
+    x.sign = xs.empty() ? 0 : 1;
+    x.limbs = xs;
+
+    return x;
+}
+
+std::vector<limb_t> random_limbs(std::mt19937_64& gen, size_t n)
+{
+    std::vector<limb_t> xs(n);
+
+    for(limb_t& x : xs) {
+        x = gen();
+    }
+
+    return xs;
+}
+}
+
+class IntBigTMulSizes : public ::testing::TestWithParam<std::pair<size_t, size_t>>
+{
+protected:
+    std::mt19937_64 gen{ 1337 };
+
+    size_t GetAn() { return GetParam().first; }
+    size_t GetBn() { return GetParam().second; }
+
+public:
+    // Product by the schoolbook algorithm, which serves as the reference
+    static std::vector<limb_t> mul_reference(const std::vector<limb_t>& a, const std::vector<limb_t>& b)
+    {
+        std::vector<limb_t> r(a.size() + b.size());
+
+        if(a.size() >= b.size()) {
+            isg::mpn::mul_basecase(r.data(), a.data(), a.size(), b.data(), b.size());
+        }
+        else {
+            isg::mpn::mul_basecase(r.data(), b.data(), b.size(), a.data(), a.size());
+        }
+
+        return r;
+    }
+};
+
+class IntBigTMulAlgorithm : public ::testing::TestWithParam<mul_case>
+{
+protected:
+    std::mt19937_64 gen{ 1337 };
+
+    std::vector<limb_t> mul_tested(const std::vector<limb_t>& a, const std::vector<limb_t>& b)
+    {
+        std::vector<limb_t> r(a.size() + b.size());
+
+        GetParam().f(r.data(), a.data(), a.size(), b.data(), b.size());
+
+        return r;
+    }
+};
+
+TEST_P(IntBigTMulAlgorithm, RandomMatchesSchoolbook) {
+    for(int i = 0; i < 10; i++) {
+        const auto a = TestData::random_limbs(gen, GetParam().an);
+        const auto b = TestData::random_limbs(gen, GetParam().bn);
+
+        ASSERT_EQ(mul_tested(a, b), IntBigTMulSizes::mul_reference(a, b)) << GetParam();
+    }
+}
+
+TEST_P(IntBigTMulAlgorithm, OnesMatchesSchoolbook) {
+    const std::vector<limb_t> a(GetParam().an, UINT64_MAX), b(GetParam().bn, UINT64_MAX);
+
+    ASSERT_EQ(mul_tested(a, b), IntBigTMulSizes::mul_reference(a, b)) << GetParam();
+}
+
+TEST_P(IntBigTMulAlgorithm, SparseMatchesSchoolbook) {
+    // Lots of zero pieces and evaluations
+    std::vector<limb_t> a(GetParam().an), b(GetParam().bn);
+
+    a.front() = a.back() = b.back() = 1;
+
+    ASSERT_EQ(mul_tested(a, b), IntBigTMulSizes::mul_reference(a, b)) << GetParam();
+}
+
+INSTANTIATE_TEST_CASE_P(Karatsuba, IntBigTMulAlgorithm, ::testing::ValuesIn(TestData::karatsuba_cases));
+INSTANTIATE_TEST_CASE_P(Toom33, IntBigTMulAlgorithm, ::testing::ValuesIn(TestData::toom33_cases));
+INSTANTIATE_TEST_CASE_P(Toom44, IntBigTMulAlgorithm, ::testing::ValuesIn(TestData::toom44_cases));
+INSTANTIATE_TEST_CASE_P(Toom32, IntBigTMulAlgorithm, ::testing::ValuesIn(TestData::toom32_cases));
+INSTANTIATE_TEST_CASE_P(Toom42, IntBigTMulAlgorithm, ::testing::ValuesIn(TestData::toom42_cases));
+INSTANTIATE_TEST_CASE_P(Ntt, IntBigTMulAlgorithm, ::testing::ValuesIn(TestData::ntt_cases));
+
+
+class IntBigTSqrAlgorithm : public ::testing::TestWithParam<sqr_case>
+{
+protected:
+    std::mt19937_64 gen{ 1337 };
+
+    std::vector<limb_t> sqr_tested(const std::vector<limb_t>& a)
+    {
+        std::vector<limb_t> r(2 * a.size());
+
+        GetParam().f(r.data(), a.data(), a.size());
+
+        return r;
+    }
+};
+
+TEST_P(IntBigTSqrAlgorithm, RandomMatchesSchoolbook) {
+    for(int i = 0; i < 3; i++) {
+        const auto a = TestData::random_limbs(gen, GetParam().n);
+
+        ASSERT_EQ(sqr_tested(a), IntBigTMulSizes::mul_reference(a, a)) << GetParam();
+    }
+}
+
+TEST_P(IntBigTSqrAlgorithm, OnesMatchesSchoolbook) {
+    const std::vector<limb_t> a(GetParam().n, UINT64_MAX);
+
+    ASSERT_EQ(sqr_tested(a), IntBigTMulSizes::mul_reference(a, a)) << GetParam();
+}
+
+TEST_P(IntBigTSqrAlgorithm, SparseMatchesSchoolbook) {
+    std::vector<limb_t> a(GetParam().n);
+
+    a.front() = a.back() = 1;
+
+    ASSERT_EQ(sqr_tested(a), IntBigTMulSizes::mul_reference(a, a)) << GetParam();
+}
+
+INSTANTIATE_TEST_CASE_P(Square, IntBigTSqrAlgorithm, ::testing::ValuesIn(TestData::sqr_cases));
+
+class IntBigTMulKernels : public ::testing::TestWithParam<isg::mpn::kernels>
+{
+protected:
+    std::mt19937_64 gen{ 1337 };
+
+    // The ones picked at startup
+    const isg::mpn::kernels initial = isg::mpn::current_kernels();
+
+    void SetUp() override
+    {
+        if(!isg::mpn::kernels_supported(GetParam())) {
+            GTEST_SKIP() << isg::mpn::kernels_name(GetParam()) << " kernels aren't supported";
+        }
+    }
+
+    void TearDown() override
+    {
+        isg::mpn::select_kernels(initial);
+    }
+};
+
+TEST_P(IntBigTMulKernels, MatchPortable) {
+    using namespace isg::mpn;
+
+    typedef limb_t (*kernel_fn)(limb_t*, const limb_t*, size_t, limb_t);
+
+    for(kernel_fn f : { mul_1, addmul_1, submul_1 }) {
+        for(size_t n = 0; n < 20; n++) {
+            const auto r = TestData::random_limbs(gen, n);
+
+            const std::pair<std::vector<limb_t>, limb_t> operands[] = {
+                    { TestData::random_limbs(gen, n), gen() },
+                    { std::vector<limb_t>(n, UINT64_MAX), UINT64_MAX }
+            };
+
+            for(const auto& x : operands) {
+                std::vector<limb_t> r_portable = r, r_tested = r;
+
+                ASSERT_TRUE(select_kernels(kernels::portable));
+                const limb_t c_portable = f(r_portable.data(), x.first.data(), n, x.second);
+
+                ASSERT_TRUE(select_kernels(GetParam()));
+                const limb_t c_tested = f(r_tested.data(), x.first.data(), n, x.second);
+
+                ASSERT_EQ(r_tested, r_portable) << n;
+                ASSERT_EQ(c_tested, c_portable) << n;
+            }
+        }
+    }
+}
+
+TEST_P(IntBigTMulKernels, ProductsMatchPortable) {
+    using namespace isg::mpn;
+
+    for(size_t n : { 1, 2, 3, 17, 24, 40, 61, 64, 300 }) {
+        const auto a = TestData::random_limbs(gen, n);
+        const auto b = TestData::random_limbs(gen, n + 3);
+
+        ASSERT_TRUE(select_kernels(kernels::portable));
+        const auto r_portable = IntBigTMulSizes::mul_reference(a, b);
+
+        ASSERT_TRUE(select_kernels(GetParam()));
+        ASSERT_EQ(IntBigTMulSizes::mul_reference(a, b), r_portable) << n;
+
+        std::vector<limb_t> r(2 * n + 3);
+        mul(r.data(), b.data(), n + 3, a.data(), n);
+        ASSERT_EQ(r, r_portable) << n;
+    }
+}
+
+TEST_P(IntBigTMulKernels, MontgomeryMatchesPortable) {
+    using namespace isg::mpn;
+
+    for(size_t n : { 1, 5, 16, 17, 32, 47, 63, 64 }) {
+        // An odd modulus and operands below it, all-ones included
+        auto m = TestData::random_limbs(gen, n);
+        m[0] |= 1;
+        m[n - 1] |= 1;
+
+        auto a = TestData::random_limbs(gen, n);
+        auto b = TestData::random_limbs(gen, n);
+        a[n - 1] = m[n - 1] - 1;
+        b[n - 1] = gen() % m[n - 1];
+
+        std::vector<limb_t> m_ones(n, UINT64_MAX), a_ones(n, UINT64_MAX);
+        a_ones[0] -= 1;
+
+        const std::vector<limb_t> cases[][3] = { { m, a, b }, { m_ones, a_ones, a_ones } };
+
+        for(const auto& c : cases) {
+            const limb_t m_inv = -binvert_limb(c[0][0]);
+
+            std::vector<limb_t> r_portable(n), r_tested(n), tp(2 * n);
+
+            ASSERT_TRUE(select_kernels(kernels::portable));
+            mont_mul(r_portable.data(), c[1].data(), c[2].data(), c[0].data(), n, m_inv, tp.data());
+
+            ASSERT_TRUE(select_kernels(GetParam()));
+            mont_mul(r_tested.data(), c[1].data(), c[2].data(), c[0].data(), n, m_inv, tp.data());
+
+            ASSERT_EQ(r_tested, r_portable) << n;
+
+            // r * B^n = a * b (mod m)
+            const intbig_t r_big = TestData::to_intbig(r_portable);
+            const intbig_t m_big = TestData::to_intbig(c[0]);
+
+            ASSERT_LT(r_big, m_big) << n;
+            ASSERT_EQ((r_big << int64_t(n * 64)) % m_big, TestData::to_intbig(c[1]) * TestData::to_intbig(c[2]) % m_big);
+        }
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(Kernels, IntBigTMulKernels,
+                        ::testing::Values(isg::mpn::kernels::portable, isg::mpn::kernels::mulx_adx,
+                                          isg::mpn::kernels::avx512_ifma));
+
+class IntBigTMulDispatch : public IntBigTMulSizes { };
+
+TEST_P(IntBigTMulDispatch, EitherOrderMatchesSchoolbook) {
+    const auto a = TestData::random_limbs(gen, GetAn());
+    const auto b = TestData::random_limbs(gen, GetBn());
+
+    std::vector<limb_t> r_ab(a.size() + b.size()), r_ba(a.size() + b.size());
+    isg::mpn::mul(r_ab.data(), a.data(), a.size(), b.data(), b.size());
+    isg::mpn::mul(r_ba.data(), b.data(), b.size(), a.data(), a.size());
+
+    ASSERT_EQ(r_ab, mul_reference(a, b)) << GetAn() << "x" << GetBn();
+    ASSERT_EQ(r_ba, r_ab) << GetBn() << "x" << GetAn();
+}
+
+TEST_P(IntBigTMulDispatch, OperatorMatchesIdentities) {
+    intbig_t a, b;
+
+    a.sign = b.sign = 1;
+    a.limbs = TestData::random_limbs(gen, GetAn());
+    b.limbs = TestData::random_limbs(gen, GetBn());
+
+    // (a + b)^2 - (a - b)^2 = 4ab
+    ASSERT_EQ((a + b) * (a + b) - (a - b) * (a - b), (a * b) << 2);
+    ASSERT_EQ(-a * b, a * -b);
+}
+
+TEST_P(IntBigTMulDispatch, SquareMatchesProduct) {
+    intbig_t a;
+
+    a.sign = -1;
+    a.limbs = TestData::random_limbs(gen, GetAn());
+
+    // Copying one of the operands keeps it from being recognized as a square
+    const intbig_t a_copy = a;
+    const intbig_t product = a * a_copy;
+
+    ASSERT_EQ(intbig_t(a).square(), product);
+    ASSERT_EQ(a * a, product);
+}
+
+INSTANTIATE_TEST_CASE_P(Sizes, IntBigTMulDispatch, ::testing::ValuesIn(TestData::dispatch_sizes));
+
+class IntBigTMulParallel : public IntBigTMulSizes
+{
+protected:
+    void TearDown() override
+    {
+        isg::mpn::set_max_threads(1);
+    }
+};
+
+TEST_P(IntBigTMulParallel, MatchesSequential) {
+    const auto a = TestData::random_limbs(gen, GetAn());
+    const auto b = TestData::random_limbs(gen, GetBn());
+
+    std::vector<limb_t> r_seq(a.size() + b.size()), r_par(a.size() + b.size());
+    std::vector<limb_t> s_seq(2 * a.size()), s_par(2 * a.size());
+
+    isg::mpn::set_max_threads(1);
+    isg::mpn::mul(r_seq.data(), a.data(), a.size(), b.data(), b.size());
+    isg::mpn::sqr(s_seq.data(), a.data(), a.size());
+
+    // More threads than there are products at any one step, so that some of them nest
+    isg::mpn::set_max_threads(5);
+    ASSERT_EQ(isg::mpn::max_threads(), 5u);
+
+    isg::mpn::mul(r_par.data(), a.data(), a.size(), b.data(), b.size());
+    isg::mpn::sqr(s_par.data(), a.data(), a.size());
+
+    ASSERT_EQ(r_par, r_seq) << GetAn() << "x" << GetBn();
+    ASSERT_EQ(s_par, s_seq) << GetAn();
+}
+
+TEST_P(IntBigTMulParallel, ThreadsChangedMidway) {
+    const auto a = TestData::random_limbs(gen, GetAn());
+    const auto b = TestData::random_limbs(gen, GetBn());
+
+    std::vector<limb_t> r_seq(a.size() + b.size()), r_par(a.size() + b.size());
+
+    isg::mpn::set_max_threads(1);
+    isg::mpn::mul(r_seq.data(), a.data(), a.size(), b.data(), b.size());
+
+    // Pools come and go while the products run on them
+    std::atomic<bool> done(false);
+
+    std::thread changer([&done] {
+        for(unsigned n = 0; !done; n++) {
+            isg::mpn::set_max_threads(n % 4 + 1);
+        }
+    });
+
+    for(int i = 0; i < 3; i++) {
+        isg::mpn::mul(r_par.data(), a.data(), a.size(), b.data(), b.size());
+
+        // Not ASSERT, which would leave the thread unjoined
+        EXPECT_EQ(r_par, r_seq) << GetAn() << "x" << GetBn();
+    }
+
+    done = true;
+    changer.join();
+}
+
+// toom44, toom42 and the NTT at the top, with Toom-Cook and Karatsuba steps below them
+INSTANTIATE_TEST_CASE_P(Sizes, IntBigTMulParallel, ::testing::Values(
+        std::make_pair<size_t, size_t>(1100, 1000), std::make_pair<size_t, size_t>(2400, 2100),
+        std::make_pair<size_t, size_t>(4500, 4000), std::make_pair<size_t, size_t>(4000, 2000),
+        std::make_pair<size_t, size_t>(12000, 11000)
+));
+
+}
@@ -0,0 +1,108 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "gtest/gtest.h"
+
+#include "intbig_t.h"
+
+/*
+ * Tests for the scratch arena: the in-place operations on numbers of bounded size shouldn't allocate after the first
+ * few rounds, which is checked by counting the calls to the global `operator new`.
+ */
+
+namespace
+{
+    std::atomic<size_t> n_allocations(0);
+}
+
+void* operator new(size_t size)
+{
+    n_allocations++;
+
+    if(void* p = std::malloc(size != 0 ? size : 1)) {
+        return p;
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+namespace IntBigTScratch
+{
+
+class IntBigTScratch : public testing::TestWithParam<size_t>
+{
+protected:
+    // A random number of exactly `n` limbs
+    static intbig_t random_limbs(const size_t n)
+    {
+        return intbig_t::random_bits(64 * n) | (intbig_t::of(1) << (64 * n - 1));
+    }
+};
+
+TEST_P(IntBigTScratch, ModularLoopDoesntAllocate) {
+    const size_t n = GetParam();
+
+    const intbig_t m = random_limbs(n) | intbig_t::of(1);
+
+    intbig_t x = random_limbs(n) % m;
+    intbig_t y = random_limbs(n) % m;
+    intbig_t q = random_limbs(2 * n);
+
+    const auto round = [&] {
+        x *= y;
+        x %= m;
+
+        y.square();
+        y %= m;
+
+        q = x;
+        q *= y;
+        q /= m;
+    };
+
+    // Lets the arena and the operands grow to their sizes
+    for(int i = 0; i < 3; i++) {
+        round();
+    }
+
+    const size_t n_before = n_allocations;
+
+    for(int i = 0; i < 20; i++) {
+        round();
+    }
+
+    ASSERT_EQ(n_allocations - n_before, 0u) << n;
+}
+
+TEST_P(IntBigTScratch, PowerModAllocationsDontDependOnExponent) {
+    const size_t n = GetParam();
+
+    const intbig_t m = random_limbs(n) | intbig_t::of(1);
+    const intbig_t x = random_limbs(n) % m;
+
+    // The lowest bits set, so that the result grows the same way with either exponent
+    const intbig_t e_short = intbig_t::of(0xFF);
+    const intbig_t e_long = random_limbs(n) | e_short;
+
+    const auto count = [&](const intbig_t& e) {
+        const size_t n_before = n_allocations;
+        const intbig_t r = x.at_power(e, m);
+
+        return n_allocations - n_before;
+    };
+
+    count(e_long);
+
+    ASSERT_EQ(count(e_short), count(e_long)) << n;
+}
+
+// From the schoolbook products past Karatsuba's, through IFMA's sizes
+INSTANTIATE_TEST_CASE_P(Sizes, IntBigTScratch, testing::Values(1, 2, 8, 16, 24, 40, 64, 100));
+
+}
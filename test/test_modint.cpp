@@ -0,0 +1,155 @@
+#include <vector>
+#include <random>
+
+#include "gtest/gtest.h"
+
+#include "intbig_t.h"
+#include "mpn.hpp"
+#include "barrett_ctx.hpp"
+#include "montgomery_ctx.hpp"
+#include "modint.hpp"
+
+#include "test_numbers.hpp"
+
+/*
+ * Tests for the residues: everything done on them is checked against the same on `intbig_t` followed by a `%`, modulo
+ * odd and even moduli of several sizes, with Barrett's and (for odd ones) Montgomery's reduction.
+ */
+
+namespace ModInt
+{
+
+using isg::modint;
+using isg::barrett_ctx;
+using isg::montgomery_ctx;
+
+namespace TestData
+{
+using TestNumbers::random_number;
+
+// (a - b) mod m, for a, b >= 0
+intbig_t sub_mod(const intbig_t& a, const intbig_t& b, const intbig_t& m)
+{
+    return (a % m + m - b % m) % m;
+}
+}
+
+class ModInt : public TestNumbers::ModulusTest
+{
+protected:
+    // Odd, or even with its low limb cleared for one in a while
+    intbig_t random_modulus(const int i, const bool odd)
+    {
+        const intbig_t m = ModulusTest::random_modulus(i);
+
+        return odd ? m : m << int64_t(i % 2 == 0 ? 1 : 64);
+    }
+
+    template<typename Ctx>
+    void check_arithmetic(const Ctx& ctx)
+    {
+        const intbig_t& m = ctx.modulus();
+
+        // Below m and not, to be reduced on the way in
+        const intbig_t a = TestData::random_number(gen, GetParam(), false) % m;
+        const intbig_t b = TestData::random_number(gen, GetParam() + 1, true);
+
+        const modint<Ctx> x(ctx, a);
+        const modint<Ctx> y(ctx, b);
+
+        ASSERT_EQ(x.value(), a) << a << " " << m;
+        ASSERT_EQ(y.value(), b % m) << b << " " << m;
+
+        ASSERT_EQ((x + y).value(), (a + b) % m) << a << " " << b << " " << m;
+        ASSERT_EQ((x - y).value(), TestData::sub_mod(a, b, m)) << a << " " << b << " " << m;
+        ASSERT_EQ((y - x).value(), TestData::sub_mod(b, a, m)) << a << " " << b << " " << m;
+        ASSERT_EQ((x * y).value(), a * b % m) << a << " " << b << " " << m;
+        ASSERT_EQ(x.squared().value(), a * a % m) << a << " " << m;
+
+        // A chain, in place
+        modint<Ctx> z = x;
+        intbig_t expected = a;
+
+        for(int i = 0; i < 10; i++) {
+            z *= y;
+            z += x;
+            z.square();
+            z -= y;
+
+            expected = TestData::sub_mod((expected * b + a) % m * ((expected * b + a) % m), b, m);
+        }
+
+        ASSERT_EQ(z.value(), expected) << a << " " << b << " " << m;
+
+        ASSERT_TRUE(x - x == modint<Ctx>(ctx, intbig_t()));
+        ASSERT_TRUE(x + y == y + x);
+        ASSERT_TRUE(x * y == y * x);
+        ASSERT_TRUE(x + modint<Ctx>(ctx, m) == x);
+    }
+
+    template<typename Ctx>
+    void check_power_and_inverse(const Ctx& ctx)
+    {
+        const intbig_t& m = ctx.modulus();
+
+        const intbig_t a = TestData::random_number(gen, GetParam() + 1, false);
+        const intbig_t e = TestData::random_number(gen, 1 + GetParam() % 3, true);
+
+        const modint<Ctx> x(ctx, a);
+
+        ASSERT_EQ(x.pow(e).value(), a.at_power(e, m)) << a << " " << e << " " << m;
+        ASSERT_EQ(x.pow(intbig_t()).value(), intbig_t::of(1) % m) << a << " " << m;
+
+        if(a.gcd(m) == 1) {
+            ASSERT_EQ((x.inverse() * x).value(), intbig_t::of(1) % m) << a << " " << m;
+        }
+        else {
+            ASSERT_THROW(x.inverse(), std::logic_error) << a << " " << m;
+        }
+    }
+};
+
+TEST_P(ModInt, ArithmeticMatchesDivision) {
+    for(int i = 0; i < 10; i++) {
+        const intbig_t m_odd = random_modulus(i, true);
+        const intbig_t m_even = random_modulus(i, false);
+
+        check_arithmetic(barrett_ctx(m_odd));
+        check_arithmetic(barrett_ctx(m_even));
+        check_arithmetic(montgomery_ctx(m_odd));
+    }
+}
+
+TEST_P(ModInt, PowerAndInverseMatch) {
+    for(int i = 0; i < 10; i++) {
+        const intbig_t m_odd = random_modulus(i, true);
+        const intbig_t m_even = random_modulus(i, false);
+
+        check_power_and_inverse(barrett_ctx(m_odd));
+        check_power_and_inverse(barrett_ctx(m_even));
+        check_power_and_inverse(montgomery_ctx(m_odd));
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(Sizes, ModInt, testing::Values(1, 2, 3, 8, 16, 33, 64));
+
+TEST(ModIntThrows, NegativeAndMixed) {
+    const intbig_t m = intbig_t::of(1000002);
+
+    const barrett_ctx ctx1(m);
+    const barrett_ctx ctx2(m);
+
+    ASSERT_THROW(modint<barrett_ctx>(ctx1, intbig_t::of(-5)), std::logic_error);
+    ASSERT_THROW(modint<montgomery_ctx>(montgomery_ctx(m + 1), intbig_t::of(-5)), std::logic_error);
+
+    const modint<barrett_ctx> x(ctx1, intbig_t::of(5));
+    const modint<barrett_ctx> y(ctx2, intbig_t::of(5));
+
+    ASSERT_THROW(x + y, std::logic_error);
+    ASSERT_THROW(x * y, std::logic_error);
+    ASSERT_THROW((void) (x == y), std::logic_error);
+
+    ASSERT_THROW(modint<barrett_ctx>(ctx1, intbig_t::of(1000)).inverse(), std::logic_error);
+}
+
+}
@@ -0,0 +1,94 @@
+#ifndef RSA_PREP_TEST_NUMBERS_HPP
+#define RSA_PREP_TEST_NUMBERS_HPP
+
+#include <vector>
+#include <random>
+
+#include "gtest/gtest.h"
+
+#include "intbig_t.h"
+#include "mpn.hpp"
+
+/*
+ * Random numbers and moduli for the tests of the arithmetic, shared by the ones that check it against `intbig_t`'s
+ */
+
+namespace TestNumbers
+{
+
+using isg::mpn::limb_t;
+
+// Zero, one, all-ones, the top bit alone or all but it, or a random one
+inline limb_t special_limb(std::mt19937_64& gen)
+{
+    switch(gen() % 6) {
+        case 0: return 0;
+        case 1: return 1;
+        case 2: return ~limb_t(0);
+        case 3: return limb_t(1) << 63;
+        case 4: return (limb_t(1) << 63) - 1;
+        default: return gen();
+    }
+}
+
+inline intbig_t to_intbig(std::vector<limb_t> xs)
+{
+    intbig_t x;
+
+    while(!xs.empty() && xs.back() == 0) {
+        xs.pop_back();
+    }
+
+    x.sign = xs.empty() ? 0 : 1;
+    x.limbs = xs;
+
+    return x;
+}
+
+// A number of exactly `n` limbs (so zero for n = 0), mostly made of special ones if `special`
+inline intbig_t random_number(std::mt19937_64& gen, const size_t n, const bool special)
+{
+    std::vector<limb_t> xs(n);
+
+    for(limb_t& x : xs) {
+        x = special ? special_limb(gen) : gen();
+    }
+
+    if(n != 0 && xs.back() == 0) {
+        xs.back() = special ? limb_t(1) << (gen() % 64) : 1;
+    }
+
+    return to_intbig(xs);
+}
+
+// An odd one of exactly `n` limbs, all-ones for one in five `i`s, and of special limbs for every other one
+inline intbig_t random_odd_modulus(std::mt19937_64& gen, const size_t n, const int i)
+{
+    if(i % 5 == 4) {
+        return (intbig_t::of(1) << int64_t(64 * n)) - 1;
+    }
+
+    intbig_t m = random_number(gen, n, i % 2 == 0);
+
+    if(!m.test_bit(0)) {
+        m += 1;
+    }
+
+    return m;
+}
+
+// For the tests modulo numbers of GetParam() limbs, seeded by it
+class ModulusTest : public testing::TestWithParam<size_t>
+{
+protected:
+    std::mt19937_64 gen{ GetParam() };
+
+    intbig_t random_modulus(const int i)
+    {
+        return random_odd_modulus(gen, GetParam(), i);
+    }
+};
+
+}
+
+#endif //RSA_PREP_TEST_NUMBERS_HPP
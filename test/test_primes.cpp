@@ -0,0 +1,188 @@
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "intbig_t.h"
+#include "primes.hpp"
+
+/*
+ * Tests for the screening of prime candidates and the residues modulo the small primes under it, and for the base-2
+ * pretest
+ */
+
+namespace Primes
+{
+
+using isg::prime_finder;
+
+namespace TestData
+{
+std::vector<intbig_t> random_numbers(const size_t n, const size_t n_bits)
+{
+    std::vector<intbig_t> xs;
+
+    for(size_t i = 0; i < n; i++) {
+        xs.push_back(intbig_t::random_bits(n_bits));
+    }
+
+    return xs;
+}
+
+// Of n_bits at most, where `intbig_t::random_bits` takes exactly that many
+intbig_t random_number(const size_t n_bits)
+{
+    return n_bits == 0 ? intbig_t() : intbig_t::random_lte((intbig_t::of(1) << int64_t(n_bits)) - 1);
+}
+}
+
+TEST(PrimesResidues, MatchDivision) {
+    const auto& primes = isg::small_residues::primes();
+
+    ASSERT_EQ(primes.size(), 131u);
+    ASSERT_EQ(primes.front(), 3u);
+    ASSERT_EQ(primes.back(), 743u);
+
+    for(const size_t n_bits : { 0, 1, 10, 64, 65, 512, 2048 }) {
+        const intbig_t x = TestData::random_number(n_bits);
+        const isg::small_residues rs(x);
+
+        for(size_t i = 0; i < primes.size(); i++) {
+            ASSERT_EQ(int64_t(rs.values()[i]), x % primes[i]) << x << " " << primes[i];
+        }
+    }
+}
+
+TEST(PrimesResidues, AdvanceMatchesDivision) {
+    const auto& primes = isg::small_residues::primes();
+
+    intbig_t x = intbig_t::random_bits(1024);
+    isg::small_residues rs(x);
+
+    // Steps both below and above the primes
+    for(const uint32_t delta : std::vector<uint32_t>{ 2, 2, 1, 742, 743, 744, 100000, 2, 4000000000u }) {
+        x += delta;
+        rs.advance(delta);
+
+        for(size_t i = 0; i < primes.size(); i++) {
+            ASSERT_EQ(int64_t(rs.values()[i]), x % primes[i]) << x << " " << primes[i];
+        }
+
+        ASSERT_EQ(rs.any_zero(), x.gcd(prime_finder().P_SMALL_PRIMES) != 1) << x;
+    }
+}
+
+TEST(PrimesPow2, MatchesPower) {
+    // Odd and even moduli, of one limb and of several
+    for(const size_t m_bits : { 2, 3, 64, 65, 512, 1024, 2048 }) {
+        for(int i = 0; i < 4; i++) {
+            const intbig_t m = (TestData::random_number(m_bits) | (intbig_t::of(1) << int64_t(m_bits - 1))) + (i % 2);
+
+            for(const size_t e_bits : { 1, 2, 63, 64, 65, 1000 }) {
+                const intbig_t e = TestData::random_number(e_bits);
+
+                ASSERT_EQ(intbig_t::pow2_mod(e, m), intbig_t::of(2).at_power(e, m)) << e << " " << m;
+            }
+
+            ASSERT_EQ(intbig_t::pow2_mod(intbig_t(), m), intbig_t::of(2).at_power(intbig_t(), m)) << m;
+        }
+    }
+
+    ASSERT_EQ(intbig_t::pow2_mod(intbig_t::of(100), intbig_t::of(1)), 0);
+}
+
+TEST(PrimesSprp2, Primes) {
+    for(const int64_t p : { 2, 3, 5, 7, 11, 743, 65537 }) {
+        ASSERT_TRUE(prime_finder::test_prime_sprp2(intbig_t::of(p))) << p;
+    }
+
+    // Mersenne primes, for which 2^q is 1 right away
+    for(const int64_t k : { 61, 89, 127, 521 }) {
+        const intbig_t p = (intbig_t::of(1) << k) - 1;
+
+        ASSERT_TRUE(prime_finder::test_prime_sprp2(p)) << p;
+    }
+
+    const intbig_t p = prime_finder().random_prime(1024);
+
+    ASSERT_TRUE(prime_finder::test_prime_sprp2(p)) << p;
+}
+
+TEST(PrimesRandom, FitTheBits) {
+    prime_finder pf;
+
+    // Short enough for the sieve to run past 2^n_bits from a good part of the starts, or for it not to do at all
+    for(const size_t n_bits : { 2, 3, 5, 9, 10, 11, 12, 16, 20 }) {
+        for(int i = 0; i < 50; i++) {
+            ASSERT_EQ(intbig_t::random_bits(n_bits).num_bits(), n_bits);
+
+            const intbig_t p = pf.random_prime(n_bits);
+
+            ASSERT_EQ(p.num_bits(), n_bits) << p;
+            ASSERT_TRUE(prime_finder::test_prime_sprp2(p)) << p;
+        }
+    }
+}
+
+TEST(PrimesSprp2, Composites) {
+    // Among them, 341 is a base-2 Fermat pseudoprime and 561 is a Carmichael number
+    for(const int64_t n : { 0, 1, 4, 9, 15, 91, 341, 561, 1105 }) {
+        ASSERT_FALSE(prime_finder::test_prime_sprp2(intbig_t::of(n))) << n;
+    }
+
+    const intbig_t n = ((intbig_t::of(1) << 61) - 1) * ((intbig_t::of(1) << 89) - 1);
+
+    ASSERT_FALSE(prime_finder::test_prime_sprp2(n)) << n;
+
+    // The smallest strong pseudoprimes to base 2, which is why it takes the random rounds after it
+    for(const int64_t n : { 2047, 3277, 4033, 4681, 8321 }) {
+        ASSERT_TRUE(prime_finder::test_prime_sprp2(intbig_t::of(n))) << n;
+    }
+}
+
+TEST(PrimesSprp2, BatchMatchesOneByOne) {
+    std::vector<intbig_t> ns;
+
+    for(const int64_t n : { 0, 1, 2, 3, 341, 561, 2047, 65537 }) {
+        ns.push_back(intbig_t::of(n));
+    }
+
+    // Enough of the same size for whole batches, primes among them
+    for(int i = 0; i < 20; i++) {
+        ns.push_back(TestData::random_number(512) | intbig_t::of(1));
+    }
+
+    ns.push_back(prime_finder().random_prime(512));
+    ns.push_back((intbig_t::of(1) << 521) - 1);
+
+    const std::vector<bool> passed = prime_finder::test_prime_sprp2(ns);
+
+    ASSERT_EQ(passed.size(), ns.size());
+
+    for(size_t i = 0; i < ns.size(); i++) {
+        ASSERT_EQ(passed[i], prime_finder::test_prime_sprp2(ns[i])) << ns[i];
+    }
+}
+
+TEST(PrimesScreening, MatchesGcd) {
+    prime_finder pf;
+
+    for(const size_t n_bits : { 64, 512, 1024, 2048 }) {
+        auto candidates = TestData::random_numbers(200, n_bits);
+
+        // A few that surely have a factor, the largest one included
+        candidates.push_back(intbig_t::of(743) * candidates[0]);
+        candidates.push_back(intbig_t::of(3 * 5 * 7) * candidates[1]);
+
+        std::vector<intbig_t> expected;
+
+        for(const intbig_t& x : candidates) {
+            if(x.gcd(pf.P_SMALL_PRIMES) == 1) {
+                expected.push_back(x);
+            }
+        }
+
+        ASSERT_EQ(pf.screen_small_factors(candidates), expected) << n_bits;
+    }
+}
+
+}